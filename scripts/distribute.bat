@@ -5,6 +5,8 @@ cmake --build . --config Release --parallel 12
 
 xcopy Release\cross.exe .\
 
-"C:\Program Files\7-Zip\7z.exe" a -tzip "CrossingTheLine-Win32.zip" res\ levels\ cross.exe 
+.\Release\nkpak.exe levels levels.nkpak
+
+"C:\Program Files\7-Zip\7z.exe" a -tzip "CrossingTheLine-Win32.zip" res\ levels.nkpak cross.exe 
 
 popd
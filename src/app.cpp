@@ -4,6 +4,7 @@
 #include "resource_database.h"
 #include "sound_manager.h"
 #include "game_event.h"
+#include "input_manager.h"
 
 #include <nikola/nikola.h>
 
@@ -22,6 +23,12 @@ struct nikola::App {
   
   StateType current_state;
   StateDesc states[STATES_MAX];
+
+  nikola::FilePath record_path; 
+  nikola::FilePath replay_path;
+  bool has_input_started = false;
+
+  GameEventScope event_scope;
 };
 /// App
 /// ----------------------------------------------------------------------
@@ -51,6 +58,29 @@ static void on_state_change(const GameEvent& event, void* dispatcher, void* list
 /// ----------------------------------------------------------------------
 /// Private functions
 
+static void parse_args(nikola::App* app, const nikola::Args& args) {
+  for(nikola::sizei i = 0; i < args.size(); i++) {
+    if(args[i] == "--record" && (i + 1) < args.size()) {
+      app->record_path = args[++i];
+    }
+    else if(args[i] == "--replay" && (i + 1) < args.size()) {
+      app->replay_path = args[++i];
+    }
+  }
+}
+
+static void begin_input(nikola::App* app) {
+  /// @NOTE: Both sides have to start on the same frame for a replay to line 
+  /// up, and that is the first frame after the level gets reset. 
+
+  if(!app->replay_path.empty()) {
+    input_manager_replay_begin(app->replay_path);
+  }
+  else if(!app->record_path.empty()) {
+    input_manager_record_begin(app->record_path);
+  }
+}
+
 static void init_states(nikola::App* app) {
   // Menu state init 
   StateDesc state_desc = {
@@ -115,6 +145,7 @@ static void init_states(nikola::App* app) {
 nikola::App* app_init(const nikola::Args& args, nikola::Window* window) {
   // App init
   nikola::App* app = new nikola::App{};
+  parse_args(app, args);
 
   // Window init
   app->window = window;
@@ -142,12 +173,18 @@ nikola::App* app_init(const nikola::Args& args, nikola::Window* window) {
   init_states(app);
 
   // Listen to events
-  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_change, app);
+  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_change, app, &app->event_scope);
 
   return app;
 }
 
 void app_shutdown(nikola::App* app) {
+  // Make sure the recording makes it to disk
+  input_manager_record_end();
+
+  // Nothing should call back into an app that is about to be deleted
+  game_event_scope_clear(&app->event_scope);
+
   level_manager_shutdown();
   resource_database_shutdown();
 
@@ -159,6 +196,9 @@ void app_shutdown(nikola::App* app) {
 }
 
 void app_update(nikola::App* app, const nikola::f64 delta_time) {
+  // Everyone sees the same input for the whole frame
+  input_manager_update((float)delta_time);
+
   // Quit the application when the specified exit key is pressed
   if(nikola::input_key_pressed(nikola::KEY_ESCAPE)) {
     nikola::event_dispatch(nikola::Event{.type = nikola::EVENT_APP_QUIT});
@@ -170,6 +210,15 @@ void app_update(nikola::App* app, const nikola::f64 delta_time) {
 
   // Update the current state
   INVOKE_STATE_CALLBACK(app->states[app->current_state].input_func);
+
+  // Everything that was queued up this frame
+  game_event_flush();
+
+  // Recordings and replays start along with the first level
+  if(app->current_state == STATE_LEVEL && !app->has_input_started) {
+    begin_input(app);
+    app->has_input_started = true;
+  }
 }
 
 void app_render(nikola::App* app) {
@@ -0,0 +1,194 @@
+#include "entity.h"
+
+#include <nikola/nikola.h>
+
+#if defined(__AVX__)
+  #define AABB_BATCH_AVX 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define AABB_BATCH_SSE 1
+#endif
+
+#if defined(AABB_BATCH_AVX) || defined(AABB_BATCH_SSE)
+  #include <immintrin.h>
+#endif
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::sizei AABB_BATCH_WORD_BITS = 64;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static void set_hits(nikola::DynamicArray<nikola::u64>& out_hits, const nikola::sizei index, const nikola::u64 bits) {
+  /// @NOTE: The SIMD widths (4 and 8) both divide 64 evenly and every
+  /// chunk starts at a multiple of its width, so a chunk never spans two words.
+  out_hits[index / AABB_BATCH_WORD_BITS] |= (bits << (index % AABB_BATCH_WORD_BITS));
+}
+
+static nikola::sizei test_scalar(const AABBBatch& batch,
+                                 const nikola::sizei start,
+                                 const nikola::Vec3& center,
+                                 const nikola::Vec3& half_extents,
+                                 nikola::DynamicArray<nikola::u64>& out_hits) {
+  for(nikola::sizei i = start; i < batch.centers_x.size(); i++) {
+    // Same rule as `entity_aabb_test`. Overlapping on ALL axises.
+
+    bool hit = nikola::abs(batch.centers_x[i] - center.x) < (batch.half_x[i] + half_extents.x) &&
+               nikola::abs(batch.centers_y[i] - center.y) < (batch.half_y[i] + half_extents.y) &&
+               nikola::abs(batch.centers_z[i] - center.z) < (batch.half_z[i] + half_extents.z);
+
+    set_hits(out_hits, i, hit ? 1 : 0);
+  }
+
+  return batch.centers_x.size();
+}
+
+#if defined(AABB_BATCH_AVX)
+
+static nikola::sizei test_avx(const AABBBatch& batch,
+                              const nikola::Vec3& center,
+                              const nikola::Vec3& half_extents,
+                              nikola::DynamicArray<nikola::u64>& out_hits) {
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+  const __m256 cx = _mm256_set1_ps(center.x);
+  const __m256 cy = _mm256_set1_ps(center.y);
+  const __m256 cz = _mm256_set1_ps(center.z);
+
+  const __m256 hx = _mm256_set1_ps(half_extents.x);
+  const __m256 hy = _mm256_set1_ps(half_extents.y);
+  const __m256 hz = _mm256_set1_ps(half_extents.z);
+
+  nikola::sizei count = batch.centers_x.size() & ~(nikola::sizei)7;
+  for(nikola::sizei i = 0; i < count; i += 8) {
+    __m256 dx = _mm256_andnot_ps(sign_mask, _mm256_sub_ps(_mm256_loadu_ps(&batch.centers_x[i]), cx));
+    __m256 dy = _mm256_andnot_ps(sign_mask, _mm256_sub_ps(_mm256_loadu_ps(&batch.centers_y[i]), cy));
+    __m256 dz = _mm256_andnot_ps(sign_mask, _mm256_sub_ps(_mm256_loadu_ps(&batch.centers_z[i]), cz));
+
+    __m256 in_x = _mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(&batch.half_x[i]), hx), _CMP_LT_OQ);
+    __m256 in_y = _mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(&batch.half_y[i]), hy), _CMP_LT_OQ);
+    __m256 in_z = _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(&batch.half_z[i]), hz), _CMP_LT_OQ);
+
+    __m256 hit = _mm256_and_ps(_mm256_and_ps(in_x, in_y), in_z);
+    set_hits(out_hits, i, (nikola::u64)_mm256_movemask_ps(hit));
+  }
+
+  return count;
+}
+
+#elif defined(AABB_BATCH_SSE)
+
+static nikola::sizei test_sse(const AABBBatch& batch,
+                              const nikola::Vec3& center,
+                              const nikola::Vec3& half_extents,
+                              nikola::DynamicArray<nikola::u64>& out_hits) {
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+  const __m128 cx = _mm_set1_ps(center.x);
+  const __m128 cy = _mm_set1_ps(center.y);
+  const __m128 cz = _mm_set1_ps(center.z);
+
+  const __m128 hx = _mm_set1_ps(half_extents.x);
+  const __m128 hy = _mm_set1_ps(half_extents.y);
+  const __m128 hz = _mm_set1_ps(half_extents.z);
+
+  nikola::sizei count = batch.centers_x.size() & ~(nikola::sizei)3;
+  for(nikola::sizei i = 0; i < count; i += 4) {
+    __m128 dx = _mm_andnot_ps(sign_mask, _mm_sub_ps(_mm_loadu_ps(&batch.centers_x[i]), cx));
+    __m128 dy = _mm_andnot_ps(sign_mask, _mm_sub_ps(_mm_loadu_ps(&batch.centers_y[i]), cy));
+    __m128 dz = _mm_andnot_ps(sign_mask, _mm_sub_ps(_mm_loadu_ps(&batch.centers_z[i]), cz));
+
+    __m128 in_x = _mm_cmplt_ps(dx, _mm_add_ps(_mm_loadu_ps(&batch.half_x[i]), hx));
+    __m128 in_y = _mm_cmplt_ps(dy, _mm_add_ps(_mm_loadu_ps(&batch.half_y[i]), hy));
+    __m128 in_z = _mm_cmplt_ps(dz, _mm_add_ps(_mm_loadu_ps(&batch.half_z[i]), hz));
+
+    __m128 hit = _mm_and_ps(_mm_and_ps(in_x, in_y), in_z);
+    set_hits(out_hits, i, (nikola::u64)_mm_movemask_ps(hit));
+  }
+
+  return count;
+}
+
+#endif
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// AABBBatch functions
+
+void aabb_batch_clear(AABBBatch* batch) {
+  NIKOLA_ASSERT(batch, "Invalid batch given to aabb_batch_clear");
+
+  batch->centers_x.clear();
+  batch->centers_y.clear();
+  batch->centers_z.clear();
+
+  batch->half_x.clear();
+  batch->half_y.clear();
+  batch->half_z.clear();
+}
+
+void aabb_batch_push(AABBBatch* batch, const nikola::Vec3& center, const nikola::Vec3& half_extents) {
+  NIKOLA_ASSERT(batch, "Invalid batch given to aabb_batch_push");
+
+  batch->centers_x.push_back(center.x);
+  batch->centers_y.push_back(center.y);
+  batch->centers_z.push_back(center.z);
+
+  batch->half_x.push_back(half_extents.x);
+  batch->half_y.push_back(half_extents.y);
+  batch->half_z.push_back(half_extents.z);
+}
+
+void aabb_batch_set(AABBBatch* batch, const nikola::sizei index, const nikola::Vec3& center, const nikola::Vec3& half_extents) {
+  NIKOLA_ASSERT(batch, "Invalid batch given to aabb_batch_set");
+  NIKOLA_ASSERT(index < batch->centers_x.size(), "Out of range index given to aabb_batch_set");
+
+  batch->centers_x[index] = center.x;
+  batch->centers_y[index] = center.y;
+  batch->centers_z[index] = center.z;
+
+  batch->half_x[index] = half_extents.x;
+  batch->half_y[index] = half_extents.y;
+  batch->half_z[index] = half_extents.z;
+}
+
+void aabb_batch_test(const AABBBatch& batch,
+                     const nikola::Vec3& center,
+                     const nikola::Vec3& half_extents,
+                     nikola::DynamicArray<nikola::u64>& out_hits) {
+  // One bit for every box, cleared
+  out_hits.assign((batch.centers_x.size() + AABB_BATCH_WORD_BITS - 1) / AABB_BATCH_WORD_BITS, 0);
+
+  // The widest path we were compiled with goes first, and
+  // the scalar path picks up whatever does not fit in a full register.
+
+  nikola::sizei tested = 0;
+
+#if defined(AABB_BATCH_AVX)
+  tested = test_avx(batch, center, half_extents, out_hits);
+#elif defined(AABB_BATCH_SSE)
+  tested = test_sse(batch, center, half_extents, out_hits);
+#endif
+
+  test_scalar(batch, tested, center, half_extents, out_hits);
+}
+
+const bool aabb_batch_is_hit(const nikola::DynamicArray<nikola::u64>& hits, const nikola::sizei index) {
+  nikola::sizei word = index / AABB_BATCH_WORD_BITS;
+  if(word >= hits.size()) {
+    return false;
+  }
+
+  return (hits[word] >> (index % AABB_BATCH_WORD_BITS)) & 1;
+}
+
+/// AABBBatch functions
+/// ----------------------------------------------------------------------
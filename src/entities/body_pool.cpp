@@ -0,0 +1,128 @@
+#include "entity.h"
+
+#include <nikola/nikola.h>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+// One bucket for every body type, each split into solid and sensor bodies
+const nikola::sizei BODY_POOL_BUCKETS_MAX = (nikola::PHYSICS_BODY_KINEMATIC + 1) * 2;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// PooledBody
+struct PooledBody {
+  nikola::PhysicsBody* body;
+  nikola::Collider* collider;
+};
+/// PooledBody
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// BodyPool
+struct BodyPool {
+  nikola::DynamicArray<PooledBody> buckets[BODY_POOL_BUCKETS_MAX];
+};
+
+static BodyPool s_pool;
+/// BodyPool
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static nikola::sizei get_bucket_index(const nikola::PhysicsBodyType type, const bool is_sensor) {
+  return ((nikola::sizei)type * 2) + (is_sensor ? 1 : 0);
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Body pool functions
+
+void body_pool_acquire(Entity* entity, const nikola::PhysicsBodyDesc& body_desc, const nikola::ColliderDesc& coll_desc) {
+  NIKOLA_ASSERT(entity, "Invalid entity given to body_pool_acquire");
+
+  /*
+   * @NOTE:
+   *
+   * Every collider in the game is a single box with no friction, so the body type
+   * and whether the collider is a sensor are the only things a body cannot be
+   * reconfigured out of. Everything else gets set again right here.
+   *
+   */
+
+  entity->body_bucket = (nikola::u32)get_bucket_index(body_desc.type, coll_desc.is_sensor);
+  nikola::DynamicArray<PooledBody>& bucket = s_pool.buckets[entity->body_bucket];
+
+  // The body only ever knows the entity by its handle
+  void* user_data = entity_slots_to_user_data(entity->handle);
+
+  // Nothing to reuse. Make a new one.
+  if(bucket.empty()) {
+    nikola::PhysicsBodyDesc desc = body_desc;
+    desc.user_data               = user_data;
+
+    entity->body     = nikola::physics_body_create(desc);
+    entity->collider = nikola::physics_body_add_collider(entity->body, coll_desc);
+
+    return;
+  }
+
+  PooledBody pooled = bucket.back();
+  bucket.pop_back();
+
+  entity->body     = pooled.body;
+  entity->collider = pooled.collider;
+
+  // Body reset
+
+  nikola::physics_body_set_position(entity->body, body_desc.position);
+  nikola::physics_body_set_rotation(entity->body, nikola::Vec3(0.0f, 1.0f, 0.0f), 0.0f);
+  nikola::physics_body_set_linear_velocity(entity->body, nikola::Vec3(0.0f));
+  nikola::physics_body_set_angular_velocity(entity->body, nikola::Vec3(0.0f));
+  nikola::physics_body_set_layers(entity->body, body_desc.layers);
+  nikola::physics_body_set_user_data(entity->body, user_data);
+  nikola::physics_body_set_awake(entity->body, true);
+
+  // Collider reset
+  nikola::collider_set_local_position(entity->collider, coll_desc.position);
+  nikola::collider_set_extents(entity->collider, coll_desc.extents);
+}
+
+void body_pool_release(Entity* entity) {
+  NIKOLA_ASSERT(entity, "Invalid entity given to body_pool_release");
+
+  if(!entity->body) {
+    return;
+  }
+
+  // Out of the way until someone needs it again
+  nikola::physics_body_set_position(entity->body, ENTITY_PARK_OFFSET);
+  nikola::physics_body_set_linear_velocity(entity->body, nikola::Vec3(0.0f));
+  nikola::physics_body_set_angular_velocity(entity->body, nikola::Vec3(0.0f));
+  nikola::physics_body_set_layers(entity->body, 0);
+  nikola::physics_body_set_user_data(entity->body, nullptr);
+  nikola::physics_body_set_awake(entity->body, false);
+
+  s_pool.buckets[entity->body_bucket].push_back(PooledBody{entity->body, entity->collider});
+
+  entity->body     = nullptr;
+  entity->collider = nullptr;
+}
+
+void body_pool_clear() {
+  for(auto& bucket : s_pool.buckets) {
+    for(auto& pooled : bucket) {
+      nikola::physics_body_destroy(pooled.body);
+    }
+
+    bucket.clear();
+  }
+}
+
+/// Body pool functions
+/// ----------------------------------------------------------------------
@@ -3,16 +3,40 @@
 
 #include <nikola/nikola.h>
 
+#include <algorithm>
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static bool diff_key_less(const DiffKey& a, const DiffKey& b) {
+  if(a.type != b.type) {
+    return a.type < b.type;
+  }
+
+  for(nikola::sizei i = 0; i < DIFF_KEY_VALUES_MAX; i++) {
+    if(a.values[i] != b.values[i]) {
+      return a.values[i] < b.values[i];
+    }
+  }
+
+  return false;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Generic entity functions
 
-void entity_create(Entity* entity, 
-                   Level* lvl,
-                   const nikola::Vec3& pos, 
-                   const nikola::Vec3& scale, 
-                   const EntityType entt_type, 
-                   const nikola::PhysicsBodyType body_type, 
-                   const bool is_sensor) {
+Entity* entity_create(Level* lvl,
+                      const nikola::Vec3& pos, 
+                      const nikola::Vec3& scale, 
+                      const EntityType entt_type, 
+                      const nikola::PhysicsBodyType body_type, 
+                      const bool is_sensor) {
+  // The slot map holds on to the entity itself, so it never moves
+  Entity* entity = entity_slots_create();
+
   // Entity variables init
   entity->type      = entt_type;
   entity->level_ref = lvl;
@@ -23,10 +47,8 @@ void entity_create(Entity* entity,
   nikola::PhysicsBodyDesc body_desc = {
     .position  = pos, 
     .type      = body_type,
-    .layers    = PHYSICS_LAYER_0,
-    .user_data = entity,
+    .layers    = entity_get_physics_layers(entt_type),
   };
-  entity->body = nikola::physics_body_create(body_desc);
 
   // Collider init
   nikola::ColliderDesc coll_desc = {
@@ -35,7 +57,16 @@ void entity_create(Entity* entity,
     .friction  = 0.0f,
     .is_sensor = is_sensor,
   };
-  entity->collider = nikola::physics_body_add_collider(entity->body, coll_desc);
+  body_pool_acquire(entity, body_desc, coll_desc);
+
+  return entity;
+}
+
+void entity_destroy(Entity* entity) {
+  NIKOLA_ASSERT(entity, "Invalid entity given to entity_destroy");
+
+  body_pool_release(entity);
+  entity_slots_destroy(entity);
 }
 
 const bool entity_aabb_test(Entity& entity, Entity& other) {
@@ -50,5 +81,55 @@ const bool entity_aabb_test(Entity& entity, Entity& other) {
   return nikola::abs(diff.x) < sum_size.x && nikola::abs(diff.y) < sum_size.y && nikola::abs(diff.z) < sum_size.z;
 }
 
+const nikola::sizei entity_get_type_index(const EntityType type) {
+  return ((nikola::sizei)type >> 5) - 1;
+}
+
+const nikola::u32 entity_get_physics_layers(const EntityType type) {
+  /// @NOTE: Only the pairs the entity manager has a collision handler for share 
+  /// a layer. The player is tested against points and vehicles by hand, so those 
+  /// (and everything else) never even make it to the physics callbacks.
+
+  switch(type) {
+    case ENTITY_PLAYER:
+      return PHYSICS_LAYER_1 | PHYSICS_LAYER_2;
+    case ENTITY_TILE:
+      return PHYSICS_LAYER_1;
+    case ENTITY_COIN:
+      return PHYSICS_LAYER_2;
+    case ENTITY_VEHICLE:
+    case ENTITY_VEHICLE_POINT:
+      return PHYSICS_LAYER_3;
+    default:
+      return 0;
+  }
+}
+
+void entity_diff_keys(nikola::DynamicArray<DiffKey>& old_keys, nikola::DynamicArray<DiffKey>& new_keys, nikola::DynamicArray<nikola::sizei>& matches) {
+  // Every new key points back to an identical old key, if there is one
+  matches.assign(new_keys.size(), DIFF_NO_MATCH);
+
+  std::sort(old_keys.begin(), old_keys.end(), diff_key_less);
+  std::sort(new_keys.begin(), new_keys.end(), diff_key_less);
+
+  // Both sides are sorted, so one walk over them is enough
+  
+  nikola::sizei old_i = 0, new_i = 0;
+  while(old_i < old_keys.size() && new_i < new_keys.size()) {
+    if(diff_key_less(old_keys[old_i], new_keys[new_i])) {
+      old_i++;
+    }
+    else if(diff_key_less(new_keys[new_i], old_keys[old_i])) {
+      new_i++;
+    }
+    else {
+      matches[new_keys[new_i].index] = old_keys[old_i].index;
+
+      old_i++;
+      new_i++;
+    }
+  }
+}
+
 /// Generic entity functions
 /// ----------------------------------------------------------------------
@@ -6,6 +6,7 @@
 
 // Much needed forward declarations
 struct Level;
+struct Entity;
 
 /// ----------------------------------------------------------------------
 
@@ -14,9 +15,37 @@ struct Level;
 
 const float TILE_SIZE = 8.0f;
 
+const float PLAYER_SPEED                    = 11.2f;
+const nikola::Vec3 PLAYER_COLLIDER_EXTENTS = nikola::Vec3(1.2f, 3.4f, 1.2f);
+
+// How far the player can go along the X axis
+const float PLAYER_MIN_X = -27.5f;
+const float PLAYER_MAX_X = 100.0f;
+
+// Where parked entities are sent to so nothing can collide with them
+const nikola::Vec3 ENTITY_PARK_OFFSET = nikola::Vec3(0.0f, -10000.0f, 0.0f);
+
+const nikola::sizei DIFF_KEY_VALUES_MAX = 7;
+const nikola::sizei DIFF_NO_MATCH       = (nikola::sizei)-1;
+
 /// Consts
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// FrustumPlane
+enum FrustumPlane {
+  FRUSTUM_PLANE_LEFT = 0, 
+  FRUSTUM_PLANE_RIGHT,
+  FRUSTUM_PLANE_BOTTOM,
+  FRUSTUM_PLANE_TOP,
+  FRUSTUM_PLANE_NEAR,
+  FRUSTUM_PLANE_FAR,
+
+  FRUSTUM_PLANES_MAX,
+};
+/// FrustumPlane
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// EntityType 
 enum EntityType {
@@ -31,6 +60,9 @@ enum EntityType {
   
   ENTITY_COIN        = 0x160,
 };
+
+// Every type above is a multiple of 0x20, starting from 0x20
+const nikola::sizei ENTITY_TYPES_MAX = 11;
 /// EntityType 
 /// ----------------------------------------------------------------------
 
@@ -42,6 +74,12 @@ enum PhysicsLayers {
 
   // Player, Tiles
   PHYSICS_LAYER_1 = 0x4,
+
+  // Player, Coin
+  PHYSICS_LAYER_2 = 0x8,
+
+  // Vehicles, Vehicle points
+  PHYSICS_LAYER_3 = 0x10,
 };
 /// PhysicsLayers
 /// ----------------------------------------------------------------------
@@ -51,6 +89,8 @@ enum PhysicsLayers {
 enum VehicleType {
   VEHICLE_CAR,
   VEHICLE_TRUCK,
+
+  VEHICLE_TYPES_MAX,
 };
 /// VehicleType
 /// ----------------------------------------------------------------------
@@ -71,6 +111,102 @@ enum TileType {
 /// TileType 
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// AABB
+struct AABB {
+  nikola::Vec3 min; 
+  nikola::Vec3 max;
+};
+/// AABB
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// AABBBatch
+struct AABBBatch {
+  nikola::DynamicArray<float> centers_x, centers_y, centers_z; 
+  nikola::DynamicArray<float> half_x, half_y, half_z;
+};
+/// AABBBatch
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Frustum
+struct Frustum {
+  nikola::Vec4 planes[FRUSTUM_PLANES_MAX];
+};
+/// Frustum
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// CullingStats
+struct CullingStats {
+  nikola::sizei visible = 0; 
+  nikola::sizei culled  = 0;
+};
+/// CullingStats
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GridRange
+struct GridRange {
+  int min_x, min_z; 
+  int max_x, max_z;
+};
+/// GridRange
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GridEntry
+struct GridEntry {
+  AABB bounds;
+  GridRange range;
+};
+/// GridEntry
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// SpatialGrid
+struct SpatialGrid {
+  // Every cell is `TILE_SIZE` wide on the XZ plane
+  nikola::HashMap<nikola::u64, nikola::DynamicArray<Entity*>> cells;
+  nikola::HashMap<Entity*, GridEntry> entries;
+};
+/// SpatialGrid
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// EntityHandle
+struct EntityHandle {
+  nikola::u32 index      = 0;
+  nikola::u32 generation = 0; // 0 is never given out, so a default handle is always invalid
+};
+/// EntityHandle
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// EntitySlot
+struct EntitySlot {
+  nikola::u32 generation = 1;
+  nikola::u32 dense_index;
+};
+/// EntitySlot
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// EntitySlotMap
+struct EntitySlotMap {
+  // The entities themselves. Pages never move, so neither do the entities.
+  nikola::DynamicArray<Entity*> pages;
+
+  nikola::DynamicArray<EntitySlot> slots;
+  nikola::DynamicArray<nikola::u32> free_slots;
+
+  // Every live handle, tightly packed
+  nikola::DynamicArray<EntityHandle> dense;
+};
+/// EntitySlotMap
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Entity 
 struct Entity {
@@ -78,9 +214,15 @@ struct Entity {
   Level* level_ref;
   bool is_active;
 
+  // What the physics world knows this entity by
+  EntityHandle handle;
+
   nikola::Vec3 start_pos;
   nikola::PhysicsBody* body; 
   nikola::Collider* collider; 
+
+  // Which bucket of the body pool the body goes back to
+  nikola::u32 body_bucket;
 };
 /// Entity 
 /// ----------------------------------------------------------------------
@@ -88,59 +230,184 @@ struct Entity {
 /// ----------------------------------------------------------------------
 /// Player 
 struct Player {
-  Entity entity; 
+  Entity* entity; 
 
   int current_footstep_sound = -1;
-  bool can_move              = true;
+  
+  // Neighbouring ground colliders overlap at the seams, so a bool would 
+  // flip to "off the ground" whenever the old tile's contact ends last.
+  nikola::u32 ground_contacts = 0;
 };
 /// Player 
 /// ----------------------------------------------------------------------
 
 /// ----------------------------------------------------------------------
-/// Vehicle 
-struct Vehicle {
-  Entity entity;
+/// VehicleStore 
+struct VehicleStore {
+  nikola::sizei count = 0;
+
+  // Read every frame
+
+  nikola::DynamicArray<nikola::Transform> transforms; // Pulled out of the bodies once per update
+  nikola::DynamicArray<nikola::Vec3> previous_positions;
+  nikola::DynamicArray<nikola::Vec3> directions;
+  nikola::DynamicArray<float> accelerations;
+  nikola::DynamicArray<nikola::u8> types;
+  nikola::DynamicArray<nikola::u8> active;
+
+  // Kinematic traffic
+  
+  bool is_kinematic = true;
+  nikola::f64 clock = 0.0; // A float stops keeping up with small steps after a while
 
-  VehicleType type;
-  float acceleration; 
+  nikola::DynamicArray<nikola::f64> spawn_times;
+  nikola::DynamicArray<float> lane_lengths; // 0 means the lane never wraps around
 
-  nikola::Vec3 direction;
-  nikola::Vec4 rotation;
+  // Only needed by the physics world and the editor
+  nikola::DynamicArray<Entity*> entities;
 };
-/// Vehicle 
+/// VehicleStore 
 /// ----------------------------------------------------------------------
 
 /// ----------------------------------------------------------------------
 /// Tile 
 struct Tile {
-  Entity entity;
+  Entity* entity;
   TileType type; 
+
+  nikola::Vec3 scale;
 };
 /// Tile 
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// DiffKey
+struct DiffKey {
+  nikola::u32 type;
+  nikola::sizei index;
+  
+  float values[DIFF_KEY_VALUES_MAX] = {0.0f};
+};
+/// DiffKey
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// TransitionStats
+struct TransitionStats {
+  nikola::sizei reused_bodies  = 0;
+  nikola::sizei rebuilt_bodies = 0;
+};
+/// TransitionStats
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Generic entity functions
 
-void entity_create(Entity* entity, 
-                   Level* lvl, 
-                   const nikola::Vec3& pos, 
-                   const nikola::Vec3& scale, 
-                   const EntityType entt_type, 
-                   const nikola::PhysicsBodyType body_type = nikola::PHYSICS_BODY_STATIC, 
-                   const bool is_sensor = false);
+Entity* entity_create(Level* lvl, 
+                      const nikola::Vec3& pos, 
+                      const nikola::Vec3& scale, 
+                      const EntityType entt_type, 
+                      const nikola::PhysicsBodyType body_type = nikola::PHYSICS_BODY_STATIC, 
+                      const bool is_sensor = false);
+
+void entity_destroy(Entity* entity);
 
 const bool entity_aabb_test(Entity& entity, Entity& other);
 
+const nikola::sizei entity_get_type_index(const EntityType type);
+
+const nikola::u32 entity_get_physics_layers(const EntityType type);
+
+void entity_diff_keys(nikola::DynamicArray<DiffKey>& old_keys, nikola::DynamicArray<DiffKey>& new_keys, nikola::DynamicArray<nikola::sizei>& matches);
+
 /// Generic entity functions
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// Entity slots functions
+
+Entity* entity_slots_create();
+
+void entity_slots_destroy(Entity* entity);
+
+void entity_slots_clear();
+
+Entity* entity_slots_get(const EntityHandle handle);
+
+Entity* entity_slots_get_body_entity(nikola::PhysicsBody* body);
+
+void* entity_slots_to_user_data(const EntityHandle handle);
+
+const nikola::DynamicArray<EntityHandle>& entity_slots_get_live();
+
+/// Entity slots functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Frustum functions
+
+void frustum_create(Frustum* frustum, const nikola::Mat4& view_projection);
+
+const bool frustum_test_aabb(const Frustum& frustum, const AABB& aabb);
+
+const AABB aabb_translate(const AABB& aabb, const nikola::Vec3& position);
+
+/// Frustum functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// AABBBatch functions
+
+void aabb_batch_clear(AABBBatch* batch);
+
+void aabb_batch_push(AABBBatch* batch, const nikola::Vec3& center, const nikola::Vec3& half_extents);
+
+void aabb_batch_set(AABBBatch* batch, const nikola::sizei index, const nikola::Vec3& center, const nikola::Vec3& half_extents);
+
+void aabb_batch_test(const AABBBatch& batch, 
+                     const nikola::Vec3& center, 
+                     const nikola::Vec3& half_extents, 
+                     nikola::DynamicArray<nikola::u64>& out_hits);
+
+const bool aabb_batch_is_hit(const nikola::DynamicArray<nikola::u64>& hits, const nikola::sizei index);
+
+/// AABBBatch functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Spatial grid functions
+
+void spatial_grid_clear(SpatialGrid* grid);
+
+void spatial_grid_insert(SpatialGrid* grid, Entity* entity, const AABB& bounds);
+
+void spatial_grid_update(SpatialGrid* grid, Entity* entity, const AABB& bounds);
+
+void spatial_grid_query_range(const SpatialGrid& grid, const AABB& range, nikola::DynamicArray<Entity*>& out_entities);
+
+/// Spatial grid functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Body pool functions
+
+void body_pool_acquire(Entity* entity, const nikola::PhysicsBodyDesc& body_desc, const nikola::ColliderDesc& coll_desc);
+
+void body_pool_release(Entity* entity);
+
+void body_pool_clear();
+
+/// Body pool functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Player functions
 
 void player_create(Player* player, Level* lvl, const nikola::Vec3& position);
 
-void player_update(Player& player); 
+void player_update(Player& player, const float delta_time); 
+
+void player_apply_forces(Player& player);
 
 void player_set_active(Player& player, const bool active);
 
@@ -150,23 +417,69 @@ void player_set_active(Player& player, const bool active);
 /// ----------------------------------------------------------------------
 /// Vehicle functions
 
-void vehicle_create(Vehicle* v,  
+void vehicle_create(VehicleStore* store,  
+                    const nikola::sizei index,
                     Level* lvl, 
                     const VehicleType type, 
                     const nikola::Vec3& position, 
                     const nikola::Vec3& dir, 
                     const float acceleration = 30.0f);
 
-void vehicle_set_active(Vehicle& v, const bool active);
+void vehicle_copy(VehicleStore* dest, const nikola::sizei dest_index, const VehicleStore& src, const nikola::sizei src_index);
+
+void vehicle_destroy(VehicleStore* store, const nikola::sizei index);
+
+void vehicle_set_active(VehicleStore* store, const nikola::sizei index, const bool active);
+
+const AABB& vehicle_get_bounds(const VehicleType type);
+
+const AABB vehicle_get_collider_box(const VehicleType type);
+
+const float vehicle_get_lane_length(const VehicleType type, 
+                                    const nikola::Vec3& start_pos, 
+                                    const nikola::Vec3& dir, 
+                                    const nikola::DynamicArray<AABB>& stops);
+
+const float vehicle_get_lane_distance(const float acceleration, const float lane_length, const nikola::f64 time);
 
 /// Vehicle functions
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// VehicleStore functions
+
+void vehicle_store_resize(VehicleStore* store, const nikola::sizei count);
+
+void vehicle_store_remove(VehicleStore* store, const nikola::sizei index);
+
+void vehicle_store_clear(VehicleStore* store);
+
+void vehicle_store_set_kinematic(VehicleStore* store, const bool kinematic);
+
+void vehicle_store_build_lanes(VehicleStore* store, const nikola::DynamicArray<Entity*>& points);
+
+void vehicle_store_update(VehicleStore* store, const float delta_time);
+
+void vehicle_store_sync(VehicleStore* store);
+
+/// VehicleStore functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Tile functions
 
 void tile_create(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& pos);
 
+void tile_create_collider(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& position, const nikola::Vec3& extents);
+
+void tile_destroy(Tile* tile);
+
+const bool tile_is_ground(const TileType type);
+
+const nikola::Vec3 tile_get_position(const TileType type, const nikola::Vec3& pos);
+
+const nikola::Vec3 tile_get_scale(const TileType type);
+
 /// Tile functions
 /// ----------------------------------------------------------------------
 
@@ -179,11 +492,21 @@ void entity_manager_destroy();
 
 void entity_manager_load();
 
+void entity_manager_park();
+
+void entity_manager_unpark();
+
+void entity_manager_transition(TransitionStats* stats);
+
 void entity_manager_save();
 
 void entity_manager_reset();
 
-void entity_manager_update();
+void entity_manager_update(const float delta_time);
+
+void entity_manager_apply_forces();
+
+void entity_manager_query_range(const AABB& range, nikola::DynamicArray<Entity*>& out_entities);
 
 void entity_manager_render();
 
@@ -201,10 +524,20 @@ void tile_manager_destroy();
 
 void tile_manager_load(); 
 
+void tile_manager_park();
+
+void tile_manager_unpark();
+
+void tile_manager_transition(TransitionStats* stats);
+
 void tile_manager_save();
 
 void tile_manager_process_input();
 
+void tile_manager_query_range(const AABB& range, nikola::DynamicArray<Tile*>& out_tiles);
+
+Tile* tile_manager_find_tile(const nikola::Vec3& position);
+
 void tile_manager_render();
 
 void tile_manager_render_gui();
@@ -9,16 +9,82 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_stdlib.h>
 
+#include <cstring>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+// Big enough for the coin's model no matter how it's rotated
+const nikola::Vec3 COIN_BOUNDS_EXTENTS = nikola::Vec3(2.5f);
+
+const ResourceType VEHICLE_RESOURCES[VEHICLE_TYPES_MAX] = {
+  RESOURCE_CAR,
+  RESOURCE_TRUCK,
+};
+
+const float VEHICLE_RENDER_SCALES[VEHICLE_TYPES_MAX] = {
+  4.0f, 
+  6.0f,
+};
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// CollisionHandler
+typedef void(*CollisionHandler)(Entity* entity, Entity* other);
+/// CollisionHandler
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// CollisionPair
+struct CollisionPair {
+  CollisionHandler begin_func = nullptr; 
+  CollisionHandler end_func   = nullptr;
+
+  // The handler wants the entities the other way around
+  bool is_swapped = false;
+};
+/// CollisionPair
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// EntityManager
 struct EntityManager {
   Level* level_ref;
 
   Player player;
-  Entity coin; 
+  Entity* coin; 
 
-  nikola::DynamicArray<Entity> points;
-  nikola::DynamicArray<Vehicle> vehicles;
+  nikola::DynamicArray<Entity*> points;
+  VehicleStore vehicles;
+
+  // The coin only spins in place
+  AABB coin_bounds;
+
+  // Entities of a level that is kept resident while another level is loaded
+  
+  nikola::DynamicArray<Entity*> parked_points;
+  VehicleStore parked_vehicles;
+
+  // Spatial look up
+
+  SpatialGrid grid;
+  bool is_grid_dirty = true;
+
+  // Player triggers
+
+  AABBBatch point_boxes; 
+  AABBBatch vehicle_boxes;
+
+  nikola::DynamicArray<nikola::u64> point_hits, last_point_hits;
+  nikola::DynamicArray<nikola::u64> vehicle_hits;
+
+  // Rendering
+  nikola::DynamicArray<nikola::Transform> vehicle_instances[VEHICLE_TYPES_MAX];
+
+  // Collisions (indexed by `entity_get_type_index`)
+  CollisionPair collision_pairs[ENTITY_TYPES_MAX][ENTITY_TYPES_MAX];
 };
 
 static EntityManager s_entt;
@@ -28,74 +94,161 @@ static EntityManager s_entt;
 /// ----------------------------------------------------------------------
 /// Private functions
 
-static void resolve_player_begin_collisions(Entity* player, Entity* other) {
-  Level* lvl = player->level_ref;
-
-  switch(other->type) {
-    case ENTITY_VEHICLE:
-      player_set_active(s_entt.player, false);
-
-      game_event_dispatch(GameEvent{
-        .type       = GAME_EVENT_STATE_CHANGED, 
-        .state_type = STATE_LOST
-      });
-      break;
-    case ENTITY_TILE: 
-      s_entt.player.can_move = true;
-      break;
-    case ENTITY_END_POINT:
-      player_set_active(s_entt.player, false);
-      game_event_dispatch(GameEvent{
-        .type       = GAME_EVENT_STATE_CHANGED, 
-        .state_type = STATE_WON
-      });
-      break;
-    case ENTITY_VEHICLE_POINT: 
-    case ENTITY_DEATH_POINT: 
-      player_set_active(s_entt.player, false);
-      game_event_dispatch(GameEvent{
-        .type       = GAME_EVENT_STATE_CHANGED, 
-        .state_type = STATE_LOST
-      });
-      break;
-    case ENTITY_CHAPTER_POINT: 
-      game_event_dispatch(GameEvent{.type = GAME_EVENT_CHAPTER_ENTERED}, other);
-      break;
-    case ENTITY_COIN:
-      other->is_active = false; 
-      nikola::physics_body_set_awake(other->body, false);
-
-      game_event_dispatch(GameEvent{.type = GAME_EVENT_COIN_COLLECTED});
-      game_event_dispatch(GameEvent{
-        .type       = GAME_EVENT_SOUND_PLAYED, 
-        .sound_type = SOUND_KEY_COLLECT,
-      });
-      break;
-    default: 
-      break;
-  }
-}
-
-static void resolve_player_end_collisions(Entity* player, Entity* other) {
-  Level* lvl = player->level_ref;
-
-  switch(other->type) {
-    case ENTITY_TILE:
-      s_entt.player.can_move = false;
-      break;
-    case ENTITY_CHAPTER_POINT: 
-      game_event_dispatch(GameEvent{.type = GAME_EVENT_CHAPTER_EXITED}, other);
-      break;
-    default: 
-      break;
-  }
-}
-
-static void resolve_vehicle_collisions(Entity* vehicle, Entity* other) {
-  // Point
-  if(other->type == ENTITY_VEHICLE_POINT) {
-    nikola::physics_body_set_position(vehicle->body, vehicle->start_pos);
+static void kill_player(Entity* player, Entity* other) {
+  player_set_active(s_entt.player, false);
+
+  game_event_dispatch(GameEvent{
+    .type       = GAME_EVENT_STATE_CHANGED, 
+    .state_type = STATE_LOST
+  });
+}
+
+static void win_player(Entity* player, Entity* other) {
+  player_set_active(s_entt.player, false);
+  
+  game_event_dispatch(GameEvent{
+    .type       = GAME_EVENT_STATE_CHANGED, 
+    .state_type = STATE_WON
+  });
+}
+
+static void enter_tile(Entity* player, Entity* tile) {
+  s_entt.player.ground_contacts++;
+}
+
+static void exit_tile(Entity* player, Entity* tile) {
+  if(s_entt.player.ground_contacts > 0) {
+    s_entt.player.ground_contacts--;
+  }
+}
+
+static int get_chapter_group(Entity* point) {
+  int pos_x = (int)nikola::physics_body_get_position(point->body).x;
+  
+  switch(pos_x) {
+    case 0:
+      return 1;
+    case 16:
+      return 2;
+    case 40:
+      return 3;
+    case 64:
+      return 4;
+  }
+}
+
+static void enter_chapter(Entity* player, Entity* point) {
+  game_event_dispatch(GameEvent{
+    .type        = GAME_EVENT_CHAPTER_ENTERED, 
+    .group_index = get_chapter_group(point),
+  });
+}
+
+static void exit_chapter(Entity* player, Entity* point) {
+  game_event_dispatch(GameEvent{
+    .type        = GAME_EVENT_CHAPTER_EXITED, 
+    .group_index = get_chapter_group(point),
+  });
+}
+
+static void collect_coin(Entity* player, Entity* coin) {
+  coin->is_active = false; 
+  nikola::physics_body_set_awake(coin->body, false);
+
+  game_event_dispatch(GameEvent{.type = GAME_EVENT_COIN_COLLECTED});
+  game_event_dispatch(GameEvent{
+    .type       = GAME_EVENT_SOUND_PLAYED, 
+    .sound_type = SOUND_KEY_COLLECT,
+  });
+}
+
+static void reset_vehicle(Entity* vehicle, Entity* point) {
+  nikola::physics_body_set_position(vehicle->body, vehicle->start_pos);
+}
+
+static void register_collision_pair(const EntityType type_a, 
+                                    const EntityType type_b, 
+                                    const CollisionHandler begin_func, 
+                                    const CollisionHandler end_func = nullptr) {
+  nikola::sizei index_a = entity_get_type_index(type_a);
+  nikola::sizei index_b = entity_get_type_index(type_b);
+
+  // Both orders lead to the same handlers
+
+  s_entt.collision_pairs[index_a][index_b] = CollisionPair{begin_func, end_func, false};
+  s_entt.collision_pairs[index_b][index_a] = CollisionPair{begin_func, end_func, (index_a != index_b)};
+}
+
+static void register_collision_pairs() {
+  /// @NOTE: Any pair registered here has to share a physics layer in 
+  /// `entity_get_physics_layers`, unless it is only dispatched by hand (like 
+  /// the player triggers). Pairs that are not registered are simply ignored.
+
+  // Player (physics)
+  
+  register_collision_pair(ENTITY_PLAYER, ENTITY_TILE, enter_tile, exit_tile);
+  register_collision_pair(ENTITY_PLAYER, ENTITY_COIN, collect_coin);
+
+  // Player (triggers)
+  
+  register_collision_pair(ENTITY_PLAYER, ENTITY_VEHICLE, kill_player);
+  register_collision_pair(ENTITY_PLAYER, ENTITY_VEHICLE_POINT, kill_player);
+  register_collision_pair(ENTITY_PLAYER, ENTITY_DEATH_POINT, kill_player);
+  register_collision_pair(ENTITY_PLAYER, ENTITY_END_POINT, win_player);
+  register_collision_pair(ENTITY_PLAYER, ENTITY_CHAPTER_POINT, enter_chapter, exit_chapter);
+
+  // Vehicles
+  register_collision_pair(ENTITY_VEHICLE, ENTITY_VEHICLE_POINT, reset_vehicle);
+}
+
+static void dispatch_collision(Entity* entt_a, Entity* entt_b, const bool is_begin) {
+  const CollisionPair& pair = s_entt.collision_pairs[entity_get_type_index(entt_a->type)][entity_get_type_index(entt_b->type)];
+  
+  CollisionHandler handler = is_begin ? pair.begin_func : pair.end_func;
+  if(!handler) {
+    return;
+  }
+
+  if(pair.is_swapped) {
+    handler(entt_b, entt_a);
+  }
+  else {
+    handler(entt_a, entt_b);
+  }
+}
+
+static void create_player_and_coin(NKLevelFile* nklvl) {
+  // Player init
+  player_create(&s_entt.player, s_entt.level_ref, nklvl->start_position);
+
+  // Coin init (just an inactive entity with no body if the level has no coin)
+ 
+  if(!nklvl->has_coin) {
+    s_entt.coin = entity_slots_create();
+    return;
   }
+
+  s_entt.coin = entity_create(s_entt.level_ref, 
+                              nklvl->coin_position,
+                              nikola::Vec3(1.4f, 0.5f, 4.0f),
+                              ENTITY_COIN, 
+                              nikola::PHYSICS_BODY_DYNAMIC, 
+                              true);
+
+  nikola::collider_set_local_position(s_entt.coin->collider, nikola::Vec3(0.0f, 0.0f, 1.6f));
+  s_entt.coin_bounds = aabb_translate(AABB{-COIN_BOUNDS_EXTENTS, COIN_BOUNDS_EXTENTS}, nklvl->coin_position);
+  
+  nikola::physics_body_set_rotation(s_entt.coin->body, nikola::Vec3(1.0f, 0.0f, 0.0f), 4.7f);
+  nikola::physics_body_set_angular_velocity(s_entt.coin->body, nikola::Vec3(0.0f, 4.5f, 0.0f));
+}
+
+static void destroy_player_and_coin() {
+  // Player destroy
+  nikola::physics_body_destroy(s_entt.player.entity->body);
+  entity_slots_destroy(s_entt.player.entity);
+
+  // Coin destroy (even if it was collected) 
+  entity_destroy(s_entt.coin);
 }
 
 /// Private functions
@@ -104,42 +257,126 @@ static void resolve_vehicle_collisions(Entity* vehicle, Entity* other) {
 /// ----------------------------------------------------------------------
 /// Callbacks
 
-static void on_entity_begin_collision(const nikola::CollisionPoint& point) {
-  // Getting the entities
-  Entity* entt_a = (Entity*)nikola::physics_body_get_user_data(point.body_a);
-  Entity* entt_b = (Entity*)nikola::physics_body_get_user_data(point.body_b);
+static AABB get_point_bounds(const Entity& point) {
+  nikola::Vec3 half_extents = nikola::collider_get_extents(point.collider) / 2.0f;
+  return AABB{point.start_pos - half_extents, point.start_pos + half_extents};
+}
 
-  // @NOTE: Yeah. Terrible. I know.
+static AABB get_vehicle_bounds(const nikola::sizei index) {
+  const VehicleStore& store = s_entt.vehicles;
+  return aabb_translate(vehicle_get_bounds((VehicleType)store.types[index]), store.transforms[index].position);
+}
 
-  // This might cause problems, but we do not 
-  // care for entities that are inactive. 
-  if(!entt_a->is_active || !entt_b->is_active) {
+static void get_collider_box(const Entity& entity, nikola::Vec3* center, nikola::Vec3* half_extents) {
+  *center       = nikola::collider_get_world_transform(entity.collider).position;
+  *half_extents = nikola::collider_get_extents(entity.collider) / 2.0f;
+}
+
+static void index_entities() {
+  /// @NOTE: The grid and the trigger boxes follow the order of the arrays, 
+  /// so anything that resizes or reorders them has to mark the grid as dirty.
+
+  spatial_grid_clear(&s_entt.grid);
+  vehicle_store_build_lanes(&s_entt.vehicles, s_entt.points);
+
+  aabb_batch_clear(&s_entt.point_boxes);
+  aabb_batch_clear(&s_entt.vehicle_boxes);
+
+  nikola::Vec3 center, half_extents;
+
+  for(auto& point : s_entt.points) {
+    spatial_grid_insert(&s_entt.grid, point, get_point_bounds(*point));
+
+    get_collider_box(*point, &center, &half_extents);
+    aabb_batch_push(&s_entt.point_boxes, center, half_extents);
+  }
+
+  for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+    Entity* entity = s_entt.vehicles.entities[i];
+    spatial_grid_insert(&s_entt.grid, entity, get_vehicle_bounds(i));
+
+    get_collider_box(*entity, &center, &half_extents);
+    aabb_batch_push(&s_entt.vehicle_boxes, center, half_extents);
+  }
+
+  // Whatever was touched before means nothing for the new arrays
+  s_entt.last_point_hits.clear();
+
+  s_entt.is_grid_dirty = false;
+}
+
+static void update_point_box(const nikola::sizei index) {
+  if(s_entt.is_grid_dirty) {
     return;
   }
 
-  // Player collisions
+  Entity* point = s_entt.points[index];
+  spatial_grid_update(&s_entt.grid, point, get_point_bounds(*point));
   
-  if(entt_a->type == ENTITY_PLAYER) {
-    resolve_player_begin_collisions(entt_a, entt_b);
+  nikola::Vec3 center, half_extents;
+  get_collider_box(*point, &center, &half_extents);
+  aabb_batch_set(&s_entt.point_boxes, index, center, half_extents);
+
+  // The lanes end wherever the vehicle points are
+  if(point->type == ENTITY_VEHICLE_POINT) {
+    vehicle_store_build_lanes(&s_entt.vehicles, s_entt.points);
   }
-  else if(entt_b->type == ENTITY_PLAYER) {
-    resolve_player_begin_collisions(entt_b, entt_a);
+}
+
+static void check_player_triggers() {
+  Entity* player = s_entt.player.entity;
+  if(!player->is_active) {
+    return;
   }
 
-  // Vehicle collisions
-  
-  if(entt_a->type == ENTITY_VEHICLE) {
-    resolve_vehicle_collisions(entt_a, entt_b);
+  nikola::Vec3 center, half_extents;
+  get_collider_box(*player, &center, &half_extents);
+
+  // Vehicles
+
+  aabb_batch_test(s_entt.vehicle_boxes, center, half_extents, s_entt.vehicle_hits);
+  for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+    if(!aabb_batch_is_hit(s_entt.vehicle_hits, i) || !s_entt.vehicles.active[i]) {
+      continue;
+    }
+
+    // Dead. Nothing else matters now.
+    dispatch_collision(player, s_entt.vehicles.entities[i], true);
+    return;
   }
-  else if(entt_b->type == ENTITY_VEHICLE) {
-    resolve_vehicle_collisions(entt_b, entt_a);
+
+  // Points
+
+  aabb_batch_test(s_entt.point_boxes, center, half_extents, s_entt.point_hits);
+  for(nikola::sizei i = 0; i < s_entt.points.size() && player->is_active; i++) {
+    Entity* point = s_entt.points[i];
+    if(!point->is_active) {
+      continue;
+    }
+
+    bool is_hit  = aabb_batch_is_hit(s_entt.point_hits, i);
+    bool was_hit = aabb_batch_is_hit(s_entt.last_point_hits, i);
+
+    if(is_hit && !was_hit) {
+      dispatch_collision(player, point, true);
+    }
+    else if(!is_hit && was_hit) {
+      dispatch_collision(player, point, false);
+    }
   }
+
+  s_entt.last_point_hits.swap(s_entt.point_hits);
 }
 
-static void on_entity_end_collision(const nikola::CollisionPoint& point) {
+static void on_entity_begin_collision(const nikola::CollisionPoint& point) {
   // Getting the entities
-  Entity* entt_a = (Entity*)nikola::physics_body_get_user_data(point.body_a);
-  Entity* entt_b = (Entity*)nikola::physics_body_get_user_data(point.body_b);
+  Entity* entt_a = entity_slots_get_body_entity(point.body_a);
+  Entity* entt_b = entity_slots_get_body_entity(point.body_b);
+
+  // Bodies sitting in the pool (or with a stale handle) belong to no one
+  if(!entt_a || !entt_b) {
+    return;
+  }
 
   // @NOTE: Yeah. Terrible. I know.
 
@@ -149,14 +386,28 @@ static void on_entity_end_collision(const nikola::CollisionPoint& point) {
     return;
   }
 
-  // Player collisions
-  
-  if(entt_a->type == ENTITY_PLAYER) {
-    resolve_player_end_collisions(entt_a, entt_b);
+  dispatch_collision(entt_a, entt_b, true);
+}
+
+static void on_entity_end_collision(const nikola::CollisionPoint& point) {
+  // Getting the entities
+  Entity* entt_a = entity_slots_get_body_entity(point.body_a);
+  Entity* entt_b = entity_slots_get_body_entity(point.body_b);
+
+  // Bodies sitting in the pool (or with a stale handle) belong to no one
+  if(!entt_a || !entt_b) {
+    return;
   }
-  else if(entt_b->type == ENTITY_PLAYER) {
-    resolve_player_end_collisions(entt_b, entt_a);
+
+  // @NOTE: Yeah. Terrible. I know.
+
+  // This might cause problems, but we do not 
+  // care for entities that are inactive. 
+  if(!entt_a->is_active || !entt_b->is_active) {
+    return;
   }
+
+  dispatch_collision(entt_a, entt_b, false);
 }
 
 /// Callbacks
@@ -170,188 +421,429 @@ void entity_manager_create(Level* level_ref) {
   s_entt.level_ref = level_ref;
  
   // Physics world callback init
+  register_collision_pairs();
   nikola::physics_world_set_collision_callback(on_entity_begin_collision, on_entity_end_collision); 
 }
 
 void entity_manager_destroy() {
-  // Player destroy
-  nikola::physics_body_destroy(s_entt.player.entity.body);
-
-  // Coin destroy 
-  if(s_entt.coin.is_active) {
-    nikola::physics_body_destroy(s_entt.coin.body);
-  } 
+  // Player and coin destroy
+  destroy_player_and_coin();
 
   // End points destroy
   for(auto& point : s_entt.points) {
-    nikola::physics_body_destroy(point.body);
+    entity_destroy(point);
   }
   s_entt.points.clear();
 
   // Vehicles destroy
-  for(auto& v : s_entt.vehicles) {
-    nikola::physics_body_destroy(v.entity.body);
-  }
-  s_entt.vehicles.clear();
+  vehicle_store_clear(&s_entt.vehicles);
+
+  // Grid destroy
+  spatial_grid_clear(&s_entt.grid);
+  s_entt.is_grid_dirty = true;
 }
 
 void entity_manager_load() {
   // For better visualization 
   NKLevelFile* nklvl = &s_entt.level_ref->nkbin;
 
-  // Player init
-  player_create(&s_entt.player, s_entt.level_ref, nklvl->start_position);
+  // Player and coin init
+  create_player_and_coin(nklvl);
 
-  // Coin init
- 
-  s_entt.coin.is_active = false;
-  if(nklvl->has_coin) {
-    entity_create(&s_entt.coin, 
-                  s_entt.level_ref, 
-                  nklvl->coin_position,
-                  nikola::Vec3(1.4f, 0.5f, 4.0f),
-                  ENTITY_COIN, 
-                  nikola::PHYSICS_BODY_DYNAMIC, 
-                  true);
-
-    nikola::collider_set_local_position(s_entt.coin.collider, nikola::Vec3(0.0f, 0.0f, 1.6f));
-    
-    nikola::physics_body_set_rotation(s_entt.coin.body, nikola::Vec3(1.0f, 0.0f, 0.0f), 4.7f);
-    nikola::physics_body_set_angular_velocity(s_entt.coin.body, nikola::Vec3(0.0f, 4.5f, 0.0f));
+  // Points init
+
+  s_entt.points.resize(nklvl->points.count);
+  for(nikola::sizei i = 0; i < s_entt.points.size(); i++) {
+    s_entt.points[i] = entity_create(s_entt.level_ref, 
+                                     nklvl->points.positions[i], 
+                                     nklvl->points.scales[i], 
+                                     (EntityType)nklvl->points.types[i],
+                                     nikola::PHYSICS_BODY_STATIC, 
+                                     true);
   }
 
-  // Points init
+  // Vehicles init
+  
+  vehicle_store_resize(&s_entt.vehicles, nklvl->vehicles.count);
+  for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+    vehicle_create(&s_entt.vehicles,  
+                   i,
+                   s_entt.level_ref, 
+                   (VehicleType)nklvl->vehicles.types[i], 
+                   nklvl->vehicles.positions[i], 
+                   nklvl->vehicles.directions[i], 
+                   nklvl->vehicles.accelerations[i]);
+  }
+
+  s_entt.is_grid_dirty = true;
+}
+
+void entity_manager_park() {
+  /// @NOTE: The player and the coin are only a couple of bodies, so they 
+  /// just get recreated. Everything else stays alive, but asleep and far 
+  /// away from anything it could collide with.
+
+  destroy_player_and_coin();
+
+  // Park the points
+  for(auto& point : s_entt.points) {
+    point->is_active = false;
+    nikola::physics_body_set_position(point->body, point->start_pos + ENTITY_PARK_OFFSET);
+  }
+
+  // Park the vehicles
+  for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+    Entity* entity = s_entt.vehicles.entities[i];
+
+    vehicle_set_active(&s_entt.vehicles, i, false);
+    nikola::physics_body_set_position(entity->body, entity->start_pos + ENTITY_PARK_OFFSET);
+  }
+
+  // Nothing was parked before, so this leaves the live arrays empty
+  s_entt.parked_points.swap(s_entt.points);
+  std::swap(s_entt.parked_vehicles, s_entt.vehicles);
+
+  spatial_grid_clear(&s_entt.grid);
+  s_entt.is_grid_dirty = true;
+}
+
+void entity_manager_unpark() {
+  NIKOLA_ASSERT(s_entt.points.empty() && s_entt.vehicles.count == 0, "Cannot unpark entities on top of a loaded level");
+
+  // Player and coin init
+  create_player_and_coin(&s_entt.level_ref->nkbin);
+
+  // Back to where we were
+  s_entt.points.swap(s_entt.parked_points);
+  std::swap(s_entt.vehicles, s_entt.parked_vehicles);
+
+  // Wake up the points
+  for(auto& point : s_entt.points) {
+    point->is_active = true;
+    nikola::physics_body_set_position(point->body, point->start_pos);
+  }
+
+  // The vehicles will be woken up once the level gets reset
+  for(auto& entity : s_entt.vehicles.entities) {
+    nikola::physics_body_set_position(entity->body, entity->start_pos);
+  }
+  vehicle_store_sync(&s_entt.vehicles);
+
+  s_entt.is_grid_dirty = true;
+}
+
+void entity_manager_transition(TransitionStats* stats) {
+  // For better visualization 
+  NKLevelFile* nklvl = &s_entt.level_ref->nkbin;
+
+  nikola::DynamicArray<DiffKey> old_keys, new_keys;
+  nikola::DynamicArray<nikola::sizei> matches;
+  nikola::DynamicArray<bool> is_kept;
+
+  // Player and coin init (only a couple of bodies, so no point in diffing them)
+
+  destroy_player_and_coin();
+  create_player_and_coin(nklvl);
+
+  stats->rebuilt_bodies += nklvl->has_coin ? 2 : 1;
+
+  // Points diff
+
+  old_keys.resize(s_entt.points.size());
+  for(nikola::sizei i = 0; i < old_keys.size(); i++) {
+    Entity* point         = s_entt.points[i];
+    nikola::Vec3 position = nikola::physics_body_get_position(point->body);
+    nikola::Vec3 scale    = nikola::collider_get_extents(point->collider);
+
+    old_keys[i] = DiffKey{.type = (nikola::u32)point->type, .index = i};
+    memcpy(&old_keys[i].values[0], &position[0], sizeof(nikola::Vec3));
+    memcpy(&old_keys[i].values[3], &scale[0], sizeof(nikola::Vec3));
+  }
+
+  new_keys.resize(nklvl->points.count);
+  for(nikola::sizei i = 0; i < new_keys.size(); i++) {
+    new_keys[i] = DiffKey{.type = (nikola::u32)nklvl->points.types[i], .index = i};
+    memcpy(&new_keys[i].values[0], &nklvl->points.positions[i][0], sizeof(nikola::Vec3));
+    memcpy(&new_keys[i].values[3], &nklvl->points.scales[i][0], sizeof(nikola::Vec3));
+  }
+
+  entity_diff_keys(old_keys, new_keys, matches);
+
+  // Keep the matching points, give back the rest, and create what's missing
+
+  nikola::DynamicArray<Entity*> points(nklvl->points.count);
+  is_kept.assign(s_entt.points.size(), false);
+
+  for(nikola::sizei i = 0; i < points.size(); i++) {
+    if(matches[i] == DIFF_NO_MATCH) {
+      continue;
+    }
+
+    points[i]           = s_entt.points[matches[i]];
+    is_kept[matches[i]] = true;
+
+    stats->reused_bodies++;
+  }
 
-  s_entt.points.resize(nklvl->points_count);
   for(nikola::sizei i = 0; i < s_entt.points.size(); i++) {
-    Entity* point = &s_entt.points[i];
+    if(!is_kept[i]) {
+      entity_destroy(s_entt.points[i]);
+    }
+  }
 
-    entity_create(point, 
-                  s_entt.level_ref, 
-                  nklvl->points[i].position, 
-                  nklvl->points[i].scale, 
-                  (EntityType)nklvl->points[i].type,
-                  nikola::PHYSICS_BODY_STATIC, 
-                  true);
+  for(nikola::sizei i = 0; i < points.size(); i++) {
+    if(matches[i] != DIFF_NO_MATCH) {
+      continue;
+    }
+
+    points[i] = entity_create(s_entt.level_ref, 
+                              nklvl->points.positions[i], 
+                              nklvl->points.scales[i], 
+                              (EntityType)nklvl->points.types[i],
+                              nikola::PHYSICS_BODY_STATIC, 
+                              true);
+    stats->rebuilt_bodies++;
   }
 
-  // Vehicles init
+  s_entt.points.swap(points);
+
+  // Vehicles diff
+
+  VehicleStore* old_vehicles = &s_entt.vehicles;
+
+  old_keys.resize(old_vehicles->count);
+  for(nikola::sizei i = 0; i < old_keys.size(); i++) {
+    old_keys[i]           = DiffKey{.type = (nikola::u32)old_vehicles->types[i], .index = i};
+    old_keys[i].values[6] = old_vehicles->accelerations[i];
+    memcpy(&old_keys[i].values[0], &old_vehicles->entities[i]->start_pos[0], sizeof(nikola::Vec3));
+    memcpy(&old_keys[i].values[3], &old_vehicles->directions[i][0], sizeof(nikola::Vec3));
+  }
+
+  new_keys.resize(nklvl->vehicles.count);
+  for(nikola::sizei i = 0; i < new_keys.size(); i++) {
+    new_keys[i]           = DiffKey{.type = (nikola::u32)nklvl->vehicles.types[i], .index = i};
+    new_keys[i].values[6] = nklvl->vehicles.accelerations[i];
+    memcpy(&new_keys[i].values[0], &nklvl->vehicles.positions[i][0], sizeof(nikola::Vec3));
+    memcpy(&new_keys[i].values[3], &nklvl->vehicles.directions[i][0], sizeof(nikola::Vec3));
+  }
+
+  entity_diff_keys(old_keys, new_keys, matches);
+
+  // Keep the matching vehicles, give back the rest, and create what's missing.
+  // The kept vehicles get put back at the start once the level resets.
+
+  VehicleStore vehicles;
+  vehicles.is_kinematic = old_vehicles->is_kinematic; 
+  vehicles.clock        = old_vehicles->clock;
   
-  s_entt.vehicles.resize(nklvl->vehicles_count);
-  for(nikola::sizei i = 0; i < s_entt.vehicles.size(); i++) {
-    Vehicle* vehicle = &s_entt.vehicles[i];
+  vehicle_store_resize(&vehicles, nklvl->vehicles.count);
+  
+  is_kept.assign(old_vehicles->count, false);
+
+  for(nikola::sizei i = 0; i < vehicles.count; i++) {
+    if(matches[i] == DIFF_NO_MATCH) {
+      continue;
+    }
+
+    vehicle_copy(&vehicles, i, *old_vehicles, matches[i]);
+    is_kept[matches[i]] = true;
 
-    vehicle_create(vehicle,  
+    stats->reused_bodies++;
+  }
+
+  for(nikola::sizei i = 0; i < old_vehicles->count; i++) {
+    if(!is_kept[i]) {
+      vehicle_destroy(old_vehicles, i);
+    }
+  }
+
+  for(nikola::sizei i = 0; i < vehicles.count; i++) {
+    if(matches[i] != DIFF_NO_MATCH) {
+      continue;
+    }
+
+    vehicle_create(&vehicles,  
+                   i,
                    s_entt.level_ref, 
-                   (VehicleType)nklvl->vehicles[i].vehicle_type, 
-                   nklvl->vehicles[i].position, 
-                   nklvl->vehicles[i].direction, 
-                   nklvl->vehicles[i].acceleration);
+                   (VehicleType)nklvl->vehicles.types[i], 
+                   nklvl->vehicles.positions[i], 
+                   nklvl->vehicles.directions[i], 
+                   nklvl->vehicles.accelerations[i]);
+    stats->rebuilt_bodies++;
   }
+
+  std::swap(s_entt.vehicles, vehicles);
+
+  s_entt.is_grid_dirty = true;
 }
 
 void entity_manager_save() {
   // For better visualization 
   NKLevelFile* nklvl = &s_entt.level_ref->nkbin;
 
+  // Make room for the entities
+  nklvl_file_resize(nklvl, s_entt.points.size(), s_entt.vehicles.count, nklvl->tiles.count);
+
   // Save the player
-  nklvl->start_position = nikola::physics_body_get_position(s_entt.player.entity.body); 
+  nklvl->start_position = nikola::physics_body_get_position(s_entt.player.entity->body); 
 
   // Save the coin 
 
-  nklvl->has_coin = s_entt.coin.is_active;
+  nklvl->has_coin = s_entt.coin->is_active;
   if(nklvl->has_coin) {
-    nklvl->coin_position = nikola::physics_body_get_position(s_entt.coin.body); 
+    nklvl->coin_position = nikola::physics_body_get_position(s_entt.coin->body); 
   }
 
   // Save the end points
 
-  nklvl->points_count = s_entt.points.size();
   for(nikola::sizei i = 0; i < s_entt.points.size(); i++) {
-    Entity* point = &s_entt.points[i];
+    Entity* point = s_entt.points[i];
 
-    nklvl->points[i].position = nikola::physics_body_get_position(point->body);
-    nklvl->points[i].scale    = nikola::collider_get_extents(point->collider);
-    nklvl->points[i].type     = (nikola::u16)point->type;
+    nklvl->points.positions[i] = nikola::physics_body_get_position(point->body);
+    nklvl->points.scales[i]    = nikola::collider_get_extents(point->collider);
+    nklvl->points.types[i]     = (nikola::u16)point->type;
   }
 
   // Save the vehicles
   
-  nklvl->vehicles_count = s_entt.vehicles.size();
-  for(nikola::sizei i = 0; i < s_entt.vehicles.size(); i++) {
-    Vehicle* vehicle = &s_entt.vehicles[i];
-
-    nklvl->vehicles[i].position     = nikola::physics_body_get_position(vehicle->entity.body); 
-    nklvl->vehicles[i].direction    = vehicle->direction; 
-    nklvl->vehicles[i].acceleration = vehicle->acceleration;
-    nklvl->vehicles[i].vehicle_type = (nikola::u8)vehicle->type; 
+  VehicleStore* vehicles = &s_entt.vehicles;
+  for(nikola::sizei i = 0; i < vehicles->count; i++) {
+    nklvl->vehicles.positions[i]     = nikola::physics_body_get_position(vehicles->entities[i]->body); 
+    nklvl->vehicles.directions[i]    = vehicles->directions[i]; 
+    nklvl->vehicles.accelerations[i] = vehicles->accelerations[i];
+    nklvl->vehicles.types[i]         = vehicles->types[i]; 
   }
 }
 
 void entity_manager_reset() {
   // Reset the player
   nikola::Vec3 player_pos = nikola::Vec3(s_entt.level_ref->nkbin.start_position.x, 0.25f, s_entt.level_ref->nkbin.start_position.z);
-  nikola::physics_body_set_position(s_entt.player.entity.body, player_pos);
+  nikola::physics_body_set_position(s_entt.player.entity->body, player_pos);
   player_set_active(s_entt.player, true);
 
-  // Reset the vehicles
-  for(auto& v : s_entt.vehicles) {
-    nikola::physics_body_set_position(v.entity.body, v.entity.start_pos);
-    vehicle_set_active(v, true);
+  // Reset the vehicles (and the time they have been driving for)
+  
+  s_entt.vehicles.clock = 0.0;
+  for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+    Entity* entity = s_entt.vehicles.entities[i];
+
+    nikola::physics_body_set_position(entity->body, entity->start_pos);
+    vehicle_set_active(&s_entt.vehicles, i, true);
   }
+  vehicle_store_sync(&s_entt.vehicles);
 
   // Reset the coin
-  if(s_entt.coin.is_active) {
-    nikola::physics_body_set_angular_velocity(s_entt.coin.body, nikola::Vec3(0.0f, 4.5f, 0.0f));
+  if(s_entt.coin->is_active) {
+    nikola::physics_body_set_angular_velocity(s_entt.coin->body, nikola::Vec3(0.0f, 4.5f, 0.0f));
   }
 }
 
-void entity_manager_update() {
+void entity_manager_update(const float delta_time) {
   // Player update
-  player_update(s_entt.player);
+  player_update(s_entt.player, delta_time);
 
   // Coin update
-  if(s_entt.coin.is_active) {
-    nikola::physics_body_set_angular_velocity(s_entt.coin.body, nikola::Vec3(0.0f, 1.5f, 0.0f));
+  if(s_entt.coin->is_active) {
+    nikola::physics_body_set_angular_velocity(s_entt.coin->body, nikola::Vec3(0.0f, 1.5f, 0.0f));
   } 
+
+  // Vehicles update
+  vehicle_store_update(&s_entt.vehicles, delta_time);
+
+  // Grid update
+  
+  if(s_entt.is_grid_dirty) {
+    index_entities();
+  }
+  else {
+    nikola::Vec3 center, half_extents;
+
+    // Only the vehicles move around
+    for(nikola::sizei i = 0; i < s_entt.vehicles.count; i++) {
+      Entity* entity = s_entt.vehicles.entities[i];
+      spatial_grid_update(&s_entt.grid, entity, get_vehicle_bounds(i));
+
+      get_collider_box(*entity, &center, &half_extents);
+      aabb_batch_set(&s_entt.vehicle_boxes, i, center, half_extents);
+    }
+  }
+
+  // Triggers update
+  check_player_triggers();
+}
+
+void entity_manager_apply_forces() {
+  player_apply_forces(s_entt.player);
+}
+
+void entity_manager_query_range(const AABB& range, nikola::DynamicArray<Entity*>& out_entities) {
+  if(s_entt.is_grid_dirty) {
+    index_entities();
+  }
+
+  spatial_grid_query_range(s_entt.grid, range, out_entities);
 }
 
 void entity_manager_render() {
   nikola::Transform transform = {}; 
 
+  Level* lvl = s_entt.level_ref;
+
   // Render vehicles
   
-  for(auto& v : s_entt.vehicles) {
-    transform = nikola::physics_body_get_transform(v.entity.body);
-
-    switch(v.type) {
-      case VEHICLE_CAR:
-        nikola::transform_scale(transform, nikola::Vec3(4.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_CAR), transform);
-        break;
-      case VEHICLE_TRUCK:
-        nikola::transform_scale(transform, nikola::Vec3(6.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_TRUCK), transform);
-        break;
+  const VehicleStore& vehicles = s_entt.vehicles;
+
+  for(auto& instances : s_entt.vehicle_instances) {
+    instances.clear();
+  }
+
+  for(nikola::sizei i = 0; i < vehicles.count; i++) {
+    if(!frustum_test_aabb(lvl->frustum, get_vehicle_bounds(i))) {
+      lvl->culling_stats.culled++;
+      continue;
     }
+    lvl->culling_stats.visible++;
+
+    // Somewhere in between the last two steps
+    transform = vehicles.transforms[i];
+    nikola::transform_translate(transform, nikola::vec3_lerp(vehicles.previous_positions[i], transform.position, lvl->step_alpha));
+    nikola::transform_scale(transform, nikola::Vec3(VEHICLE_RENDER_SCALES[vehicles.types[i]]));
+    
+    s_entt.vehicle_instances[vehicles.types[i]].push_back(transform);
+  }
 
-    if(s_entt.level_ref->debug_mode) {
-      nikola::renderer_debug_collider(v.entity.collider, nikola::Vec3(1.0f, 0.0f, 0.0f));
+  // One draw for every vehicle type 
+  for(nikola::sizei i = 0; i < VEHICLE_TYPES_MAX; i++) {
+    if(!s_entt.vehicle_instances[i].empty()) {
+      nikola::renderer_queue_model_instanced(resource_database_get(VEHICLE_RESOURCES[i]), 
+                                             s_entt.vehicle_instances[i].data(), 
+                                             s_entt.vehicle_instances[i].size());
+    }
+  }
+
+  if(s_entt.level_ref->debug_mode) {
+    for(auto& entity : vehicles.entities) {
+      nikola::renderer_debug_collider(entity->collider, nikola::Vec3(1.0f, 0.0f, 0.0f));
     }
   }
 
   // Render the coin
   
-  if(s_entt.coin.is_active) {
-    transform = nikola::physics_body_get_transform(s_entt.coin.body);
+  if(s_entt.coin->is_active && frustum_test_aabb(lvl->frustum, s_entt.coin_bounds)) {
+    transform = nikola::physics_body_get_transform(s_entt.coin->body);
     
     nikola::transform_scale(transform, nikola::Vec3(0.025f));
     nikola::renderer_queue_model(resource_database_get(RESOURCE_COIN), transform);
+    
+    lvl->culling_stats.visible++;
+  }
+  else if(s_entt.coin->is_active) {
+    lvl->culling_stats.culled++;
   }
 
   // Render the player 
  
-  transform = nikola::physics_body_get_transform(s_entt.player.entity.body);
+  transform = nikola::physics_body_get_transform(s_entt.player.entity->body);
   nikola::transform_scale(transform, nikola::Vec3(1.2f, 3.0f, 1.2f));
   nikola::renderer_queue_mesh(resource_database_get(RESOURCE_CUBE), transform);
 
@@ -359,46 +851,53 @@ void entity_manager_render() {
   
   if(s_entt.level_ref->debug_mode) {
     // Player
-    nikola::renderer_debug_collider(s_entt.player.entity.collider);
+    nikola::renderer_debug_collider(s_entt.player.entity->collider);
 
     // Points
     for(auto& point : s_entt.points) {
-      nikola::renderer_debug_collider(point.collider);
+      nikola::renderer_debug_collider(point->collider);
     }
 
     // Coin 
-    if(s_entt.coin.is_active) {
-      nikola::renderer_debug_collider(s_entt.coin.collider); 
+    if(s_entt.coin->is_active) {
+      nikola::renderer_debug_collider(s_entt.coin->collider); 
     } 
   }
 }
 
 void entity_manager_render_gui() {
+  // Every entity, parked ones included
+  ImGui::Text("Live entities: %zu", entity_slots_get_live().size());
+
   // Player
   if(ImGui::CollapsingHeader("Player")) {
-    nikola::gui_edit_physics_body("Player body", s_entt.player.entity.body);
-    nikola::gui_edit_collider("Player collider", s_entt.player.entity.collider);
+    nikola::gui_edit_physics_body("Player body", s_entt.player.entity->body);
+    nikola::gui_edit_collider("Player collider", s_entt.player.entity->collider);
   }
 
   // Coin
   if(ImGui::CollapsingHeader("Coin")) {
-    nikola::gui_edit_physics_body("Coin body", s_entt.coin.body);
-    nikola::gui_edit_collider("Coin collider", s_entt.coin.collider);
+    nikola::gui_edit_physics_body("Coin body", s_entt.coin->body);
+    nikola::gui_edit_collider("Coin collider", s_entt.coin->collider);
+    
+    // The body might have been moved
+    nikola::Vec3 coin_position = nikola::physics_body_get_position(s_entt.coin->body);
+    s_entt.coin_bounds         = aabb_translate(AABB{-COIN_BOUNDS_EXTENTS, COIN_BOUNDS_EXTENTS}, coin_position);
 
     // Collider offset
-    nikola::Vec3 offset = nikola::collider_get_local_transform(s_entt.coin.collider).position;
+    nikola::Vec3 offset = nikola::collider_get_local_transform(s_entt.coin->collider).position;
     if(ImGui::DragFloat3("Collider offset", &offset[0], 0.1f)) {
-      nikola::collider_set_local_position(s_entt.coin.collider, offset);
+      nikola::collider_set_local_position(s_entt.coin->collider, offset);
     }
 
     // Rotation
-    nikola::Vec4 rotation = nikola::physics_body_get_rotation(s_entt.coin.body);
+    nikola::Vec4 rotation = nikola::physics_body_get_rotation(s_entt.coin->body);
     if(ImGui::DragFloat4("Rotation Axis", &rotation[0], 0.1f)) {
-      nikola::physics_body_set_rotation(s_entt.coin.body, nikola::Vec3(rotation), rotation.w);
+      nikola::physics_body_set_rotation(s_entt.coin->body, nikola::Vec3(rotation), rotation.w);
     }
 
     // Active state
-    ImGui::Checkbox("Active", &s_entt.coin.is_active);
+    ImGui::Checkbox("Active", &s_entt.coin->is_active);
   }
   
   // Points
@@ -407,7 +906,7 @@ void entity_manager_render_gui() {
 
     for(nikola::sizei i = 0; i < s_entt.points.size(); i++) {
       nikola::String name = ("Point " + std::to_string(i)); 
-      Entity* entity      = &s_entt.points[i];
+      Entity* entity      = s_entt.points[i];
       
       ImGui::SeparatorText(name.c_str());
       ImGui::PushID(name.c_str());
@@ -417,16 +916,21 @@ void entity_manager_render_gui() {
       if(ImGui::DragFloat3("Position", &position[0], 0.1f)) {
         nikola::physics_body_set_position(entity->body, position);
         entity->start_pos = position;
+
+        update_point_box(i);
       }
 
       // Size
       nikola::Vec3 size = nikola::collider_get_extents(entity->collider);
       if(ImGui::DragFloat3("Extents", &size[0], 0.1f)) {
         nikola::collider_set_extents(entity->collider, size);
+        update_point_box(i);
       } 
 
       // Type
       if(ImGui::BeginCombo("Type", "End point")) {
+        EntityType old_type = entity->type;
+
         if(ImGui::Selectable("End point")) {
           entity->type = ENTITY_END_POINT;
         } 
@@ -439,13 +943,24 @@ void entity_manager_render_gui() {
         else if(ImGui::Selectable("Chapter point")) {
           entity->type = ENTITY_CHAPTER_POINT;
         }
+        
+        // Different types collide with different things
+        nikola::physics_body_set_layers(entity->body, entity_get_physics_layers(entity->type));
+
+        // The lanes end wherever the vehicle points are
+        if(old_type != entity->type && (old_type == ENTITY_VEHICLE_POINT || entity->type == ENTITY_VEHICLE_POINT)) {
+          vehicle_store_build_lanes(&s_entt.vehicles, s_entt.points);
+        }
 
         ImGui::EndCombo();
       }
       
       // Remove the point
       if(ImGui::Button("Remove")) {
+        entity_destroy(entity);
         s_entt.points.erase(s_entt.points.begin() + i);
+        
+        s_entt.is_grid_dirty = true;
       }
       
       ImGui::PopID();
@@ -468,27 +983,38 @@ void entity_manager_render_gui() {
 
     // Add an point
     if(ImGui::Button("Add point")) {
-      s_entt.points.resize(s_entt.points.size() + 1);
-      entity_create(&s_entt.points[s_entt.points.size() - 1],
-                    s_entt.level_ref,
-                    position,
-                    scale,
-                    point_types[current_point]);
+      s_entt.points.push_back(entity_create(s_entt.level_ref,
+                                            position,
+                                            scale,
+                                            point_types[current_point], 
+                                            nikola::PHYSICS_BODY_STATIC, 
+                                            true));
+      
+      s_entt.is_grid_dirty = true;
     }
   }
   
   // Vehicles
   if(ImGui::CollapsingHeader("Vehicles")) {
-    ImGui::Text("Vehicles count: %zu", s_entt.vehicles.size());
+    VehicleStore* vehicles = &s_entt.vehicles;
+    ImGui::Text("Vehicles count: %zu", vehicles->count);
       
     // Clear all
     if(ImGui::Button("Clear all")) {
-      s_entt.vehicles.clear();
+      vehicle_store_clear(vehicles);
+      s_entt.is_grid_dirty = true;
     }
 
-    for(nikola::sizei i = 0; i < s_entt.vehicles.size(); i++) {
+    // Traffic mode
+    bool is_kinematic = vehicles->is_kinematic;
+    if(ImGui::Checkbox("Kinematic traffic", &is_kinematic)) {
+      vehicle_store_set_kinematic(vehicles, is_kinematic);
+      s_entt.is_grid_dirty = true;
+    }
+
+    for(nikola::sizei i = 0; i < vehicles->count; i++) {
       nikola::String name  = ("Vehicle " + std::to_string(i)); 
-      Entity* vehicle_entt = &s_entt.vehicles[i].entity;
+      Entity* vehicle_entt = vehicles->entities[i];
       
       ImGui::SeparatorText(name.c_str());
       ImGui::PushID(name.c_str());
@@ -498,6 +1024,8 @@ void entity_manager_render_gui() {
       if(ImGui::DragFloat3("Position", &position[0], 2.0f)) {
         nikola::physics_body_set_position(vehicle_entt->body, position);
         vehicle_entt->start_pos = position;
+        
+        s_entt.is_grid_dirty = true;
       }
 
       // Size
@@ -513,23 +1041,28 @@ void entity_manager_render_gui() {
       }
       
       // Acceleration
-      if(ImGui::DragFloat("Acceleration", &s_entt.vehicles[i].acceleration, 0.1f)) {
+      if(ImGui::DragFloat("Acceleration", &vehicles->accelerations[i], 0.1f)) {
         // @TEMP: Little hack because I'm lazy
-        vehicle_set_active(s_entt.vehicles[i], false); 
-        vehicle_set_active(s_entt.vehicles[i], true); 
+        vehicle_set_active(vehicles, i, false); 
+        vehicle_set_active(vehicles, i, true); 
       }
 
       // Direction 
-      ImGui::DragFloat3("Direction", &s_entt.vehicles[i].direction[0], 1.0f, -1.0f, 1.0f);
+      if(ImGui::DragFloat3("Direction", &vehicles->directions[i][0], 1.0f, -1.0f, 1.0f)) {
+        s_entt.is_grid_dirty = true;
+      }
 
       // Active state
-      if(ImGui::Checkbox("Active", &vehicle_entt->is_active)) {
-        vehicle_set_active(s_entt.vehicles[i], vehicle_entt->is_active);
+      bool is_active = vehicles->active[i];
+      if(ImGui::Checkbox("Active", &is_active)) {
+        vehicle_set_active(vehicles, i, is_active);
       }
 
       // Remove the vehicle
       if(ImGui::Button("Remove")) {
-        s_entt.vehicles.erase(s_entt.vehicles.begin() + i);
+        vehicle_store_remove(vehicles, i);
+        
+        s_entt.is_grid_dirty = true;
       }
 
       ImGui::PopID();
@@ -555,14 +1088,17 @@ void entity_manager_render_gui() {
 
     // Add a vehicle
     if(ImGui::Button("Add vehicle")) {
-      s_entt.vehicles.resize(s_entt.vehicles.size() + 1);
+      vehicle_store_resize(vehicles, vehicles->count + 1);
 
-      vehicle_create(&s_entt.vehicles[s_entt.vehicles.size() - 1], 
+      vehicle_create(vehicles, 
+                     vehicles->count - 1,
                      s_entt.level_ref, 
                      (VehicleType)type, 
                      position, 
                      dir, 
                      accel);
+      
+      s_entt.is_grid_dirty = true;
     }
   }
 }
@@ -0,0 +1,159 @@
+#include "entity.h"
+
+#include <nikola/nikola.h>
+
+#include <cstdint>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::u32 ENTITY_SLOT_DENSE_NONE = (nikola::u32)-1;
+
+// Entities are allocated this many at a time
+const nikola::sizei ENTITY_SLOTS_PAGE_SIZE = 256;
+
+// Handles get packed into the bodies' user data, with half of the bits for each side
+const nikola::sizei ENTITY_HANDLE_BITS = sizeof(uintptr_t) * 4;
+const uintptr_t ENTITY_HANDLE_MASK     = ((uintptr_t)1 << ENTITY_HANDLE_BITS) - 1;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Globals
+
+static EntitySlotMap s_slots;
+
+/// Globals
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static Entity* get_slot_entity(const nikola::u32 index) {
+  return &s_slots.pages[index / ENTITY_SLOTS_PAGE_SIZE][index % ENTITY_SLOTS_PAGE_SIZE];
+}
+
+static EntitySlot* get_slot(const EntityHandle handle) {
+  if(handle.index >= s_slots.slots.size()) {
+    return nullptr;
+  }
+
+  // A removed (and maybe reused) slot has moved on to the next generation
+  EntitySlot* slot = &s_slots.slots[handle.index];
+  if(slot->generation != handle.generation || slot->dense_index == ENTITY_SLOT_DENSE_NONE) {
+    return nullptr;
+  }
+
+  return slot;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Entity slots functions
+
+Entity* entity_slots_create() {
+  // Reuse a free slot if there is one
+
+  nikola::u32 index;
+  if(!s_slots.free_slots.empty()) {
+    index = s_slots.free_slots.back();
+    s_slots.free_slots.pop_back();
+  }
+  else {
+    index = (nikola::u32)s_slots.slots.size();
+    NIKOLA_ASSERT(index < ENTITY_HANDLE_MASK, "Too many entities to fit in a handle");
+
+    s_slots.slots.push_back(EntitySlot{});
+
+    // Full up. The old pages stay where they are.
+    if((index % ENTITY_SLOTS_PAGE_SIZE) == 0) {
+      s_slots.pages.push_back(new Entity[ENTITY_SLOTS_PAGE_SIZE]);
+    }
+  }
+
+  EntitySlot* slot  = &s_slots.slots[index];
+  slot->dense_index = (nikola::u32)s_slots.dense.size();
+
+  EntityHandle handle = {
+    .index      = index,
+    .generation = slot->generation,
+  };
+  s_slots.dense.push_back(handle);
+
+  Entity* entity = get_slot_entity(index);
+  *entity        = Entity{};
+  entity->handle = handle;
+
+  return entity;
+}
+
+void entity_slots_destroy(Entity* entity) {
+  NIKOLA_ASSERT(entity, "Invalid entity given to entity_slots_destroy");
+
+  EntitySlot* slot = get_slot(entity->handle);
+  if(!slot) {
+    return;
+  }
+
+  // Swap the last live handle into the hole to keep them packed
+
+  EntityHandle last                     = s_slots.dense.back();
+  s_slots.dense[slot->dense_index]      = last;
+  s_slots.slots[last.index].dense_index = slot->dense_index;
+  s_slots.dense.pop_back();
+
+  // Anyone still holding on to this handle gets nothing from now on
+
+  slot->dense_index = ENTITY_SLOT_DENSE_NONE;
+  slot->generation  = (slot->generation + 1) & (nikola::u32)ENTITY_HANDLE_MASK;
+
+  // Skip 0 when wrapping around. That one is never valid.
+  if(slot->generation == 0) {
+    slot->generation = 1;
+  }
+
+  s_slots.free_slots.push_back(entity->handle.index);
+  entity->handle = EntityHandle{};
+}
+
+void entity_slots_clear() {
+  for(auto& page : s_slots.pages) {
+    delete[] page;
+  }
+
+  s_slots.pages.clear();
+  s_slots.slots.clear();
+  s_slots.free_slots.clear();
+  s_slots.dense.clear();
+}
+
+Entity* entity_slots_get(const EntityHandle handle) {
+  EntitySlot* slot = get_slot(handle);
+  return slot ? get_slot_entity(handle.index) : nullptr;
+}
+
+Entity* entity_slots_get_body_entity(nikola::PhysicsBody* body) {
+  // The handle is packed right into the user data. See `entity_slots_to_user_data`.
+
+  uintptr_t packed    = (uintptr_t)nikola::physics_body_get_user_data(body);
+  EntityHandle handle = {
+    .index      = (nikola::u32)(packed & ENTITY_HANDLE_MASK),
+    .generation = (nikola::u32)(packed >> ENTITY_HANDLE_BITS),
+  };
+
+  return entity_slots_get(handle);
+}
+
+void* entity_slots_to_user_data(const EntityHandle handle) {
+  return (void*)(((uintptr_t)handle.generation << ENTITY_HANDLE_BITS) | (uintptr_t)handle.index);
+}
+
+const nikola::DynamicArray<EntityHandle>& entity_slots_get_live() {
+  return s_slots.dense;
+}
+
+/// Entity slots functions
+/// ----------------------------------------------------------------------
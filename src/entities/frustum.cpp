@@ -0,0 +1,57 @@
+#include "entity.h"
+
+#include <nikola/nikola.h>
+
+/// ----------------------------------------------------------------------
+/// Frustum functions
+
+void frustum_create(Frustum* frustum, const nikola::Mat4& view_projection) {
+  NIKOLA_ASSERT(frustum, "Invalid frustum given to frustum_create");
+
+  /*
+   * @NOTE:
+   *
+   * Pulling the planes straight out of the view-projection matrix (Gribb-Hartmann). 
+   * The matrix is column-major, so `view_projection[col][row]`. Each plane is a 
+   * combination of the last row with one of the other three.
+   *
+   */
+
+  nikola::Vec4 rows[4];
+  for(int i = 0; i < 4; i++) {
+    rows[i] = nikola::Vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+  }
+
+  frustum->planes[FRUSTUM_PLANE_LEFT]   = rows[3] + rows[0];
+  frustum->planes[FRUSTUM_PLANE_RIGHT]  = rows[3] - rows[0];
+  frustum->planes[FRUSTUM_PLANE_BOTTOM] = rows[3] + rows[1];
+  frustum->planes[FRUSTUM_PLANE_TOP]    = rows[3] - rows[1];
+  frustum->planes[FRUSTUM_PLANE_NEAR]   = rows[3] + rows[2];
+  frustum->planes[FRUSTUM_PLANE_FAR]    = rows[3] - rows[2];
+}
+
+const bool frustum_test_aabb(const Frustum& frustum, const AABB& aabb) {
+  for(int i = 0; i < FRUSTUM_PLANES_MAX; i++) {
+    const nikola::Vec4& plane = frustum.planes[i];
+
+    // Only the corner furthest along the plane's normal matters. 
+    // If even that one is behind the plane, the whole box is.
+    
+    nikola::Vec3 corner = nikola::Vec3(plane.x >= 0.0f ? aabb.max.x : aabb.min.x, 
+                                       plane.y >= 0.0f ? aabb.max.y : aabb.min.y, 
+                                       plane.z >= 0.0f ? aabb.max.z : aabb.min.z);
+
+    if((plane.x * corner.x) + (plane.y * corner.y) + (plane.z * corner.z) + plane.w < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const AABB aabb_translate(const AABB& aabb, const nikola::Vec3& position) {
+  return AABB{aabb.min + position, aabb.max + position};
+}
+
+/// Frustum functions
+/// ----------------------------------------------------------------------
@@ -0,0 +1,179 @@
+#include "entity.h"
+
+#include <nikola/nikola.h>
+
+#include <cmath>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const float GRID_CELL_SIZE = TILE_SIZE;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static int get_cell(const float value) {
+  return (int)floorf(value / GRID_CELL_SIZE);
+}
+
+static GridRange get_range(const AABB& bounds) {
+  return GridRange {
+    .min_x = get_cell(bounds.min.x),
+    .min_z = get_cell(bounds.min.z),
+    .max_x = get_cell(bounds.max.x),
+    .max_z = get_cell(bounds.max.z),
+  };
+}
+
+static nikola::u64 pack_cell(const int x, const int z) {
+  return ((nikola::u64)(nikola::u32)x << 32) | (nikola::u64)(nikola::u32)z;
+}
+
+static bool range_contains(const GridRange& range, const int x, const int z) {
+  return x >= range.min_x && x <= range.max_x && z >= range.min_z && z <= range.max_z;
+}
+
+static bool aabb_overlaps(const AABB& a, const AABB& b) {
+  return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+         a.min.y <= b.max.y && a.max.y >= b.min.y &&
+         a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static void add_to_cell(SpatialGrid* grid, Entity* entity, const int x, const int z) {
+  grid->cells[pack_cell(x, z)].push_back(entity);
+}
+
+static void remove_from_cell(SpatialGrid* grid, Entity* entity, const int x, const int z) {
+  auto it = grid->cells.find(pack_cell(x, z));
+  if(it == grid->cells.end()) {
+    return;
+  }
+
+  // Order does not matter in a cell, so just swap it with the last one
+
+  nikola::DynamicArray<Entity*>& cell = it->second;
+  for(nikola::sizei i = 0; i < cell.size(); i++) {
+    if(cell[i] != entity) {
+      continue;
+    }
+
+    cell[i] = cell.back();
+    cell.pop_back();
+    break;
+  }
+
+  if(cell.empty()) {
+    grid->cells.erase(it);
+  }
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Spatial grid functions
+
+void spatial_grid_clear(SpatialGrid* grid) {
+  NIKOLA_ASSERT(grid, "Invalid grid given to spatial_grid_clear");
+
+  grid->cells.clear();
+  grid->entries.clear();
+}
+
+void spatial_grid_insert(SpatialGrid* grid, Entity* entity, const AABB& bounds) {
+  NIKOLA_ASSERT(grid, "Invalid grid given to spatial_grid_insert");
+  NIKOLA_ASSERT(entity, "Invalid entity given to spatial_grid_insert");
+
+  // Already in there? Just move it then.
+  if(grid->entries.find(entity) != grid->entries.end()) {
+    spatial_grid_update(grid, entity, bounds);
+    return;
+  }
+
+  GridRange range       = get_range(bounds);
+  grid->entries[entity] = GridEntry{bounds, range};
+
+  for(int z = range.min_z; z <= range.max_z; z++) {
+    for(int x = range.min_x; x <= range.max_x; x++) {
+      add_to_cell(grid, entity, x, z);
+    }
+  }
+}
+
+void spatial_grid_update(SpatialGrid* grid, Entity* entity, const AABB& bounds) {
+  NIKOLA_ASSERT(grid, "Invalid grid given to spatial_grid_update");
+
+  auto it = grid->entries.find(entity);
+  if(it == grid->entries.end()) {
+    spatial_grid_insert(grid, entity, bounds);
+    return;
+  }
+
+  GridEntry* entry    = &it->second;
+  GridRange old_range = entry->range;
+  GridRange new_range = get_range(bounds);
+
+  entry->bounds = bounds;
+  entry->range  = new_range;
+
+  // Most of the time, nothing moves far enough to leave its cells
+  if(old_range.min_x == new_range.min_x && old_range.min_z == new_range.min_z &&
+     old_range.max_x == new_range.max_x && old_range.max_z == new_range.max_z) {
+    return;
+  }
+
+  // Only touch the cells that were left or entered
+
+  for(int z = old_range.min_z; z <= old_range.max_z; z++) {
+    for(int x = old_range.min_x; x <= old_range.max_x; x++) {
+      if(!range_contains(new_range, x, z)) {
+        remove_from_cell(grid, entity, x, z);
+      }
+    }
+  }
+
+  for(int z = new_range.min_z; z <= new_range.max_z; z++) {
+    for(int x = new_range.min_x; x <= new_range.max_x; x++) {
+      if(!range_contains(old_range, x, z)) {
+        add_to_cell(grid, entity, x, z);
+      }
+    }
+  }
+}
+
+void spatial_grid_query_range(const SpatialGrid& grid, const AABB& range, nikola::DynamicArray<Entity*>& out_entities) {
+  GridRange query = get_range(range);
+
+  for(int z = query.min_z; z <= query.max_z; z++) {
+    for(int x = query.min_x; x <= query.max_x; x++) {
+      auto cell = grid.cells.find(pack_cell(x, z));
+      if(cell == grid.cells.end()) {
+        continue;
+      }
+
+      for(auto& entity : cell->second) {
+        const GridEntry& entry = grid.entries.at(entity);
+
+        // Bigger entities live in more than one cell. Only report
+        // them from the first cell both ranges have in common.
+
+        int first_x = entry.range.min_x > query.min_x ? entry.range.min_x : query.min_x;
+        int first_z = entry.range.min_z > query.min_z ? entry.range.min_z : query.min_z;
+
+        if(x != first_x || z != first_z) {
+          continue;
+        }
+
+        if(aabb_overlaps(entry.bounds, range)) {
+          out_entities.push_back(entity);
+        }
+      }
+    }
+  }
+}
+
+/// Spatial grid functions
+/// ----------------------------------------------------------------------
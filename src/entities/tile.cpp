@@ -4,63 +4,114 @@
 #include <nikola/nikola.h>
 
 /// ----------------------------------------------------------------------
-/// Tile functions
+/// Private functions
 
-void tile_create(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& pos) {
-  nikola::Vec3 scale    = nikola::Vec3(TILE_SIZE, 1.0f, TILE_SIZE);
-  nikola::Vec3 position = pos;
+static void get_tile_shape(const TileType type, const nikola::Vec3& pos, nikola::Vec3* position, nikola::Vec3* scale) {
+  *scale    = nikola::Vec3(TILE_SIZE, 1.0f, TILE_SIZE);
+  *position = pos;
 
   // Different states depending on the tiles
   switch(type) {
     case TILE_PAVIMENT:
-      position.y = -1.95f; 
+      position->y = -1.95f; 
       break;
     case TILE_CONE:
-      scale      = nikola::Vec3(2.0f);
-      position.y = -1.2f; 
+      *scale      = nikola::Vec3(2.0f);
+      position->y = -1.2f; 
       break;
     case TILE_TUNNEL_ONE_WAY:
-      scale      = nikola::Vec3(18.0f, 10.0f, 24.0f);
-      position.y = 5.3f;
+      *scale      = nikola::Vec3(18.0f, 10.0f, 24.0f);
+      position->y = 5.3f;
       break;
     case TILE_TUNNEL_TWO_WAY:
-      scale      = nikola::Vec3(24.0f, 10.0f, 24.0f);
-      position.y = 5.3f;
+      *scale      = nikola::Vec3(24.0f, 10.0f, 24.0f);
+      position->y = 5.3f;
       break;
     case TILE_TUNNEL_THREE_WAY:
-      scale      = nikola::Vec3(30.0f, 10.0f, 24.0f);
-      position.y = 5.3f;
+      *scale      = nikola::Vec3(30.0f, 10.0f, 24.0f);
+      position->y = 5.3f;
       break;
     default:
       break;
   }
+}
 
+static void init_tile(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& position, const nikola::Vec3& scale) {
   // Entity variables init
-  tile->entity.type      = ENTITY_TILE;
-  tile->entity.level_ref = lvl;
-  tile->entity.is_active = true;
-  tile->entity.start_pos = position;
+  tile->entity            = entity_slots_create();
+  tile->entity->type      = ENTITY_TILE;
+  tile->entity->level_ref = lvl;
+  tile->entity->is_active = true;
+  tile->entity->start_pos = position;
   
   // Tile variables init 
-  tile->type = type; 
+  tile->type  = type; 
+  tile->scale = scale;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Tile functions
+
+void tile_create(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& pos) {
+  nikola::Vec3 scale, position;
+  get_tile_shape(type, pos, &position, &scale);
+
+  // Ground tiles do not get a body of their own. The tile 
+  // manager merges them into bigger colliders instead.
+  if(tile_is_ground(type)) {
+    init_tile(tile, lvl, type, position, scale);
+    return;
+  }
+
+  tile_create_collider(tile, lvl, type, position, scale);
+}
+
+void tile_create_collider(Tile* tile, Level* lvl, const TileType type, const nikola::Vec3& position, const nikola::Vec3& extents) {
+  init_tile(tile, lvl, type, position, extents);
 
   // Body init
   nikola::PhysicsBodyDesc body_desc = {
-    .position  = tile->entity.start_pos, 
+    .position  = tile->entity->start_pos, 
     .type      = nikola::PHYSICS_BODY_STATIC,
-    .layers    = PHYSICS_LAYER_1,
-    .user_data = &tile->entity,
+    .layers    = entity_get_physics_layers(ENTITY_TILE),
   };
-  tile->entity.body = nikola::physics_body_create(body_desc);
 
   // Collider init
   nikola::ColliderDesc coll_desc = {
     .position  = nikola::Vec3(0.0f),
-    .extents   = scale,
+    .extents   = extents,
     .friction  = 0.0f,
     .is_sensor = false,
   };
-  tile->entity.collider = nikola::physics_body_add_collider(tile->entity.body, coll_desc);
+  body_pool_acquire(tile->entity, body_desc, coll_desc);
+}
+
+void tile_destroy(Tile* tile) {
+  NIKOLA_ASSERT(tile, "Invalid tile given to tile_destroy");
+
+  entity_destroy(tile->entity);
+  tile->entity = nullptr;
+}
+
+const bool tile_is_ground(const TileType type) {
+  return type == TILE_ROAD || type == TILE_PAVIMENT;
+}
+
+const nikola::Vec3 tile_get_position(const TileType type, const nikola::Vec3& pos) {
+  nikola::Vec3 scale, position;
+  get_tile_shape(type, pos, &position, &scale);
+
+  return position;
+}
+
+const nikola::Vec3 tile_get_scale(const TileType type) {
+  nikola::Vec3 scale, position;
+  get_tile_shape(type, nikola::Vec3(0.0f), &position, &scale);
+
+  return scale;
 }
 
 /// Tile functions
@@ -7,6 +7,65 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_stdlib.h>
 
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+// Ground tiles are matched up in steps of this size. Anything closer counts as the same spot.
+const float GROUND_MERGE_PRECISION = 0.01f;
+
+// How far up and down tile queries look from a position
+const float TILE_QUERY_DEPTH = 100.0f;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GroundCell
+struct GroundCell {
+  TileType type;
+
+  // Cells can only merge when all of these match
+  int plane, phase_x, phase_z; 
+ 
+  // Cell coordinates on the tile lattice
+  int x, z;
+
+  nikola::Vec3 position;
+};
+/// GroundCell
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GroundBox
+struct GroundBox {
+  TileType type;
+
+  nikola::Vec3 position; 
+  nikola::Vec3 extents;
+};
+/// GroundBox
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// TileRenderGroup
+struct TileRenderGroup {
+  nikola::ResourceID resource_id; 
+  nikola::ResourceID material_id;
+  bool is_model;
+
+  nikola::DynamicArray<nikola::Transform> transforms;
+  nikola::DynamicArray<AABB> bounds;
+
+  // Rebuilt every frame from whatever survives culling
+  nikola::DynamicArray<nikola::Transform> visible;
+};
+/// TileRenderGroup
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// TileManager
 struct TileManager {
@@ -16,6 +75,31 @@ struct TileManager {
   nikola::Vec3 selected_size = nikola::Vec3(TILE_SIZE, 1.0f, TILE_SIZE); 
 
   nikola::DynamicArray<Tile> tiles;
+  nikola::DynamicArray<Tile> parked_tiles;
+
+  // Road and paviment tiles merged into as few boxes as possible
+  
+  nikola::DynamicArray<Tile> ground_colliders;
+  nikola::DynamicArray<Tile> parked_ground_colliders;
+  bool is_ground_dirty = false;
+
+  // Final transforms of every tile type, submitted with one draw each. 
+  // Tiles never move, so this only gets rebuilt when the tiles change.
+  
+  TileRenderGroup render_groups[TILE_NONE];
+  bool is_render_dirty = true;
+
+  // Every tile indexed by where it is, for picking
+  
+  SpatialGrid grid;
+  nikola::HashMap<Entity*, nikola::sizei> tile_indices;
+  bool is_grid_dirty = true;
+
+  // Reused by every query, so looking things up never allocates once warmed up
+  
+  nikola::DynamicArray<Entity*> query_entities;
+  nikola::DynamicArray<Tile*> query_tiles;
+
   nikola::Vec3 debug_selection;
 };
 
@@ -23,6 +107,324 @@ static TileManager s_tiles;
 /// TileManager
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static int quantize(const float value) {
+  return (int)roundf(value / GROUND_MERGE_PRECISION);
+}
+
+static int floor_div(const int value, const int divisor) {
+  int result = value / divisor;
+  return ((value % divisor) != 0 && (value < 0)) ? (result - 1) : result;
+}
+
+static nikola::u64 pack_cell(const int x, const int z) {
+  return ((nikola::u64)(nikola::u32)x << 32) | (nikola::u64)(nikola::u32)z;
+}
+
+static bool ground_cell_less(const GroundCell& a, const GroundCell& b) {
+  if(a.type != b.type) {
+    return a.type < b.type;
+  }
+  if(a.plane != b.plane) {
+    return a.plane < b.plane;
+  }
+  if(a.phase_x != b.phase_x) {
+    return a.phase_x < b.phase_x;
+  }
+  if(a.phase_z != b.phase_z) {
+    return a.phase_z < b.phase_z;
+  }
+  if(a.z != b.z) {
+    return a.z < b.z;
+  }
+
+  return a.x < b.x;
+}
+
+static bool ground_cell_same_group(const GroundCell& a, const GroundCell& b) {
+  return a.type == b.type && a.plane == b.plane && a.phase_x == b.phase_x && a.phase_z == b.phase_z;
+}
+
+static void merge_ground_group(const nikola::DynamicArray<GroundCell>& cells, 
+                               const nikola::sizei begin, 
+                               const nikola::sizei end, 
+                               nikola::DynamicArray<bool>& visited, 
+                               nikola::DynamicArray<GroundBox>& boxes) {
+  nikola::HashMap<nikola::u64, nikola::sizei> lookup;
+  for(nikola::sizei i = begin; i < end; i++) {
+    lookup[pack_cell(cells[i].x, cells[i].z)] = i;
+  }
+
+  auto is_free = [&](const int x, const int z) {
+    auto it = lookup.find(pack_cell(x, z));
+    return it != lookup.end() && !visited[it->second];
+  };
+
+  // The cells are sorted row by row, so every unvisited cell 
+  // is the top-left corner of the next rectangle.
+
+  for(nikola::sizei i = begin; i < end; i++) {
+    if(visited[i]) {
+      continue;
+    }
+    visited[i] = true;
+
+    const GroundCell& cell = cells[i];
+
+    // Grow along the row as far as possible...
+    
+    int width = 1;
+    while(is_free(cell.x + width, cell.z)) {
+      width++;
+    }
+
+    // ...then keep adding rows as long as they are just as wide
+    
+    int depth = 1;
+    while(true) {
+      bool is_row_free = true;
+      for(int x = 0; x < width && is_row_free; x++) {
+        is_row_free = is_free(cell.x + x, cell.z + depth);
+      }
+
+      if(!is_row_free) {
+        break;
+      }
+      depth++;
+    }
+
+    for(int z = 0; z < depth; z++) {
+      for(int x = 0; x < width; x++) {
+        auto it = lookup.find(pack_cell(cell.x + x, cell.z + z));
+        if(it != lookup.end()) {
+          visited[it->second] = true;
+        }
+      }
+    }
+
+    GroundBox box = {
+      .type     = cell.type,
+      .position = cell.position + nikola::Vec3((width - 1) * TILE_SIZE, 0.0f, (depth - 1) * TILE_SIZE) / 2.0f,
+      .extents  = nikola::Vec3(width * TILE_SIZE, 1.0f, depth * TILE_SIZE),
+    };
+    boxes.push_back(box);
+  }
+}
+
+static void merge_ground_tiles(nikola::DynamicArray<GroundBox>& boxes) {
+  const int tile_size = quantize(TILE_SIZE);
+  nikola::DynamicArray<GroundCell> cells;
+
+  for(auto& tile : s_tiles.tiles) {
+    if(!tile_is_ground(tile.type) || !tile.entity->is_active) {
+      continue;
+    }
+
+    // Resized tiles do not line up with anything. They get a box of their own.
+    if(tile.scale != nikola::Vec3(TILE_SIZE, 1.0f, TILE_SIZE)) {
+      boxes.push_back(GroundBox{tile.type, tile.entity->start_pos, tile.scale});
+      continue;
+    }
+
+    // Tiles can be placed off the lattice (the editor moves them in smaller 
+    // steps), so only tiles with the same offset from it can be merged.
+
+    int pos_x = quantize(tile.entity->start_pos.x);
+    int pos_z = quantize(tile.entity->start_pos.z);
+    
+    GroundCell cell = {
+      .type     = tile.type, 
+      .plane    = quantize(tile.entity->start_pos.y),
+      .x        = floor_div(pos_x, tile_size), 
+      .z        = floor_div(pos_z, tile_size),
+      .position = tile.entity->start_pos,
+    };
+    cell.phase_x = pos_x - (cell.x * tile_size);
+    cell.phase_z = pos_z - (cell.z * tile_size);
+
+    cells.push_back(cell);
+  }
+
+  std::sort(cells.begin(), cells.end(), ground_cell_less);
+  nikola::DynamicArray<bool> visited(cells.size(), false);
+
+  nikola::sizei begin = 0;
+  while(begin < cells.size()) {
+    nikola::sizei end = begin + 1;
+    while(end < cells.size() && ground_cell_same_group(cells[begin], cells[end])) {
+      end++;
+    }
+
+    merge_ground_group(cells, begin, end, visited, boxes);
+    begin = end;
+  }
+}
+
+static void sync_ground_colliders(TransitionStats* stats) {
+  nikola::DynamicArray<GroundBox> boxes;
+  merge_ground_tiles(boxes);
+
+  // Boxes that did not change keep their bodies
+
+  nikola::DynamicArray<DiffKey> old_keys(s_tiles.ground_colliders.size());
+  for(nikola::sizei i = 0; i < old_keys.size(); i++) {
+    Tile* collider = &s_tiles.ground_colliders[i];
+
+    old_keys[i] = DiffKey{.type = (nikola::u32)collider->type, .index = i};
+    memcpy(&old_keys[i].values[0], &collider->entity->start_pos[0], sizeof(nikola::Vec3));
+    memcpy(&old_keys[i].values[3], &collider->scale[0], sizeof(nikola::Vec3));
+  }
+
+  nikola::DynamicArray<DiffKey> new_keys(boxes.size());
+  for(nikola::sizei i = 0; i < new_keys.size(); i++) {
+    new_keys[i] = DiffKey{.type = (nikola::u32)boxes[i].type, .index = i};
+    memcpy(&new_keys[i].values[0], &boxes[i].position[0], sizeof(nikola::Vec3));
+    memcpy(&new_keys[i].values[3], &boxes[i].extents[0], sizeof(nikola::Vec3));
+  }
+
+  nikola::DynamicArray<nikola::sizei> matches;
+  entity_diff_keys(old_keys, new_keys, matches);
+
+  nikola::DynamicArray<Tile> colliders(boxes.size());
+  nikola::DynamicArray<bool> is_kept(s_tiles.ground_colliders.size(), false);
+
+  for(nikola::sizei i = 0; i < colliders.size(); i++) {
+    if(matches[i] == DIFF_NO_MATCH) {
+      continue;
+    }
+
+    colliders[i]        = s_tiles.ground_colliders[matches[i]];
+    is_kept[matches[i]] = true;
+
+    stats->reused_bodies++;
+  }
+
+  for(nikola::sizei i = 0; i < s_tiles.ground_colliders.size(); i++) {
+    if(!is_kept[i]) {
+      tile_destroy(&s_tiles.ground_colliders[i]);
+    }
+  }
+
+  for(nikola::sizei i = 0; i < colliders.size(); i++) {
+    if(matches[i] != DIFF_NO_MATCH) {
+      continue;
+    }
+
+    tile_create_collider(&colliders[i], s_tiles.level_ref, boxes[i].type, boxes[i].position, boxes[i].extents);
+    stats->rebuilt_bodies++;
+  }
+
+  s_tiles.ground_colliders.swap(colliders);
+  s_tiles.is_ground_dirty = false;
+}
+
+static nikola::Vec3 get_tile_render_scale(const Tile& tile) {
+  switch(tile.type) {
+    case TILE_CONE:
+      return nikola::Vec3(4.0f);
+    case TILE_TUNNEL_ONE_WAY:
+      return nikola::Vec3(1.5f, 2.0f, 1.0f);
+    case TILE_TUNNEL_TWO_WAY:
+      return nikola::Vec3(2.0f, 2.0f, 1.0f);
+    case TILE_TUNNEL_THREE_WAY:
+      return nikola::Vec3(3.0f, 2.0f, 1.0f);
+    default: // Road and paviment
+      return tile.scale;
+  }
+}
+
+static AABB get_tile_bounds(const Tile& tile) {
+  nikola::Vec3 half_extents = tile.scale / 2.0f;
+
+  // Anything with a body could have been rotated in the editor, 
+  // so make the bounds wide enough for any rotation around Y.
+  if(tile.entity->body) {
+    float radius   = nikola::vec3_length(nikola::Vec3(tile.scale.x, 0.0f, tile.scale.z)) / 2.0f;
+    half_extents.x = radius;
+    half_extents.z = radius;
+  }
+
+  return AABB{tile.entity->start_pos - half_extents, tile.entity->start_pos + half_extents};
+}
+
+static void invalidate_tiles() {
+  s_tiles.is_render_dirty = true;
+  s_tiles.is_grid_dirty   = true;
+}
+
+static void index_tiles() {
+  spatial_grid_clear(&s_tiles.grid);
+  s_tiles.tile_indices.clear();
+
+  for(auto& tile : s_tiles.tiles) {
+    spatial_grid_insert(&s_tiles.grid, tile.entity, get_tile_bounds(tile));
+    s_tiles.tile_indices[tile.entity] = (nikola::sizei)(&tile - s_tiles.tiles.data());
+  }
+
+  s_tiles.is_grid_dirty = false;
+}
+
+static void bake_render_groups() {
+  // Resolve the resources of every group
+
+  for(nikola::sizei i = 0; i < TILE_NONE; i++) {
+    TileRenderGroup* group = &s_tiles.render_groups[i];
+    group->transforms.clear();
+    group->bounds.clear();
+
+    switch((TileType)i) {
+      case TILE_PAVIMENT:
+        group->resource_id = resource_database_get(RESOURCE_CUBE);
+        group->material_id = resource_database_get(RESOURCE_MATERIAL_PAVIMENT);
+        group->is_model    = false;
+        break;
+      case TILE_ROAD:
+        group->resource_id = resource_database_get(RESOURCE_CUBE);
+        group->material_id = resource_database_get(RESOURCE_MATERIAL_ROAD);
+        group->is_model    = false;
+        break;
+      case TILE_CONE:
+        group->resource_id = resource_database_get(RESOURCE_CONE);
+        group->is_model    = true;
+        break;
+      default: // Tunnels
+        group->resource_id = resource_database_get(RESOURCE_TUNNEL);
+        group->is_model    = true;
+        break;
+    }
+  }
+
+  // Bake the transforms 
+
+  nikola::Transform transform = {};
+  for(auto& tile : s_tiles.tiles) {
+    if(tile.type >= TILE_NONE) {
+      continue;
+    }
+
+    // Ground tiles do not have a body. The rest might have been rotated in the editor.
+    if(tile.entity->body) {
+      transform = nikola::physics_body_get_transform(tile.entity->body);
+    }
+    else {
+      transform = {};
+      nikola::transform_translate(transform, tile.entity->start_pos);
+    }
+
+    nikola::transform_scale(transform, get_tile_render_scale(tile));
+    
+    s_tiles.render_groups[tile.type].transforms.push_back(transform);
+    s_tiles.render_groups[tile.type].bounds.push_back(get_tile_bounds(tile));
+  }
+
+  s_tiles.is_render_dirty = false;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Tile manager functions
 
@@ -37,9 +439,16 @@ void tile_manager_create(Level* level_ref) {
 void tile_manager_destroy() {
   // Tiles destroy
   for(auto& tile : s_tiles.tiles) {
-    nikola::physics_body_destroy(tile.entity.body);
+    tile_destroy(&tile);
   }
   s_tiles.tiles.clear();
+  invalidate_tiles();
+
+  // Ground colliders destroy
+  for(auto& collider : s_tiles.ground_colliders) {
+    tile_destroy(&collider);
+  }
+  s_tiles.ground_colliders.clear();
 }
 
 void tile_manager_load() {
@@ -48,15 +457,140 @@ void tile_manager_load() {
   
   // Load the tiles
   
-  s_tiles.tiles.resize(nklvl->tiles_count);
+  s_tiles.tiles.resize(nklvl->tiles.count);
   for(nikola::sizei i = 0; i < s_tiles.tiles.size(); i++) {
     Tile* tile = &s_tiles.tiles[i];
 
     tile_create(tile,  
                 s_tiles.level_ref, 
-                (TileType)nklvl->tiles[i].tile_type, 
-                nklvl->tiles[i].position);
+                (TileType)nklvl->tiles.types[i], 
+                nklvl->tiles.positions[i]);
+  }
+
+  invalidate_tiles();
+
+  // Merge the ground
+  
+  TransitionStats stats = {};
+  sync_ground_colliders(&stats);
+
+  NIKOLA_LOG_DEBUG("Merged ground tiles into %zu colliders", s_tiles.ground_colliders.size());
+}
+
+void tile_manager_park() {
+  for(auto& tile : s_tiles.tiles) {
+    tile.entity->is_active = false;
+    
+    if(tile.entity->body) {
+      nikola::physics_body_set_position(tile.entity->body, tile.entity->start_pos + ENTITY_PARK_OFFSET);
+    }
+  }
+
+  for(auto& collider : s_tiles.ground_colliders) {
+    collider.entity->is_active = false;
+    nikola::physics_body_set_position(collider.entity->body, collider.entity->start_pos + ENTITY_PARK_OFFSET);
+  }
+
+  // Nothing was parked before, so this leaves the live arrays empty
+  s_tiles.parked_tiles.swap(s_tiles.tiles);
+  s_tiles.parked_ground_colliders.swap(s_tiles.ground_colliders);
+  invalidate_tiles();
+}
+
+void tile_manager_unpark() {
+  NIKOLA_ASSERT(s_tiles.tiles.empty(), "Cannot unpark tiles on top of a loaded level");
+  
+  s_tiles.tiles.swap(s_tiles.parked_tiles);
+  s_tiles.ground_colliders.swap(s_tiles.parked_ground_colliders);
+  invalidate_tiles();
+
+  for(auto& tile : s_tiles.tiles) {
+    tile.entity->is_active = true;
+    
+    if(tile.entity->body) {
+      nikola::physics_body_set_position(tile.entity->body, tile.entity->start_pos);
+    }
+  }
+
+  for(auto& collider : s_tiles.ground_colliders) {
+    collider.entity->is_active = true;
+    nikola::physics_body_set_position(collider.entity->body, collider.entity->start_pos);
+  }
+}
+
+void tile_manager_transition(TransitionStats* stats) {
+  // For better visualization 
+  NKLevelFile* nklvl = &s_tiles.level_ref->nkbin;
+
+  // Figure out which tiles are already in the right place
+
+  nikola::DynamicArray<DiffKey> old_keys(s_tiles.tiles.size());
+  for(nikola::sizei i = 0; i < old_keys.size(); i++) {
+    Tile* tile = &s_tiles.tiles[i];
+
+    old_keys[i] = DiffKey{.type = (nikola::u32)tile->type, .index = i};
+    memcpy(old_keys[i].values, &tile->entity->start_pos[0], sizeof(nikola::Vec3));
+  }
+
+  nikola::DynamicArray<DiffKey> new_keys(nklvl->tiles.count);
+  for(nikola::sizei i = 0; i < new_keys.size(); i++) {
+    TileType type         = (TileType)nklvl->tiles.types[i];
+    nikola::Vec3 position = tile_get_position(type, nklvl->tiles.positions[i]);
+
+    new_keys[i] = DiffKey{.type = (nikola::u32)type, .index = i};
+    memcpy(new_keys[i].values, &position[0], sizeof(nikola::Vec3));
+  }
+
+  nikola::DynamicArray<nikola::sizei> matches;
+  entity_diff_keys(old_keys, new_keys, matches);
+
+  // Keep the matching tiles as they are
+
+  nikola::DynamicArray<Tile> tiles(nklvl->tiles.count);
+  nikola::DynamicArray<bool> is_kept(s_tiles.tiles.size(), false);
+
+  for(nikola::sizei i = 0; i < tiles.size(); i++) {
+    if(matches[i] == DIFF_NO_MATCH) {
+      continue;
+    }
+
+    tiles[i]            = s_tiles.tiles[matches[i]];
+    is_kept[matches[i]] = true;
+   
+    // Ground tiles have no body to speak of
+    if(tiles[i].entity->body) {
+      stats->reused_bodies++;
+    }
+  }
+
+  // Give back the leftovers first, so the new tiles can take their bodies
+
+  for(nikola::sizei i = 0; i < s_tiles.tiles.size(); i++) {
+    if(!is_kept[i]) {
+      tile_destroy(&s_tiles.tiles[i]);
+    }
+  }
+
+  for(nikola::sizei i = 0; i < tiles.size(); i++) {
+    if(matches[i] != DIFF_NO_MATCH) {
+      continue;
+    }
+
+    tile_create(&tiles[i],  
+                s_tiles.level_ref, 
+                (TileType)nklvl->tiles.types[i], 
+                nklvl->tiles.positions[i]);
+    
+    if(tiles[i].entity->body) {
+      stats->rebuilt_bodies++;
+    }
   }
+
+  s_tiles.tiles.swap(tiles);
+  invalidate_tiles();
+
+  // The merged ground gets diffed just the same
+  sync_ground_colliders(stats);
 }
 
 void tile_manager_save() {
@@ -65,12 +599,12 @@ void tile_manager_save() {
  
   // Save the tiles
   
-  nklvl->tiles_count = s_tiles.tiles.size();
+  nklvl_file_resize(nklvl, nklvl->points.count, nklvl->vehicles.count, s_tiles.tiles.size());
   for(nikola::sizei i = 0; i < s_tiles.tiles.size(); i++) {
     Tile* tile = &s_tiles.tiles[i];
 
-    nklvl->tiles[i].position  = nikola::physics_body_get_position(tile->entity.body);
-    nklvl->tiles[i].tile_type = (nikola::u8)tile->type;
+    nklvl->tiles.positions[i] = tile->entity->start_pos;
+    nklvl->tiles.types[i]     = (nikola::u8)tile->type;
   }
 }
 
@@ -152,49 +686,109 @@ void tile_manager_process_input() {
   if(nikola::input_key_pressed(nikola::KEY_ENTER)) {
     s_tiles.tiles.resize(s_tiles.tiles.size() + 1);
     tile_create(&s_tiles.tiles[s_tiles.tiles.size() - 1], s_tiles.level_ref, s_tiles.selected_type, s_tiles.debug_selection);
+    invalidate_tiles();
+
+    if(tile_is_ground(s_tiles.selected_type)) {
+      TransitionStats stats = {};
+      sync_ground_colliders(&stats);
+    }
+  }
+
+  // Goodbye to whatever tile is under the selection
+
+  if(nikola::input_key_pressed(nikola::KEY_DELETE)) {
+    Tile* tile = tile_manager_find_tile(s_tiles.debug_selection);
+    if(!tile) {
+      return;
+    }
+
+    bool is_ground = tile_is_ground(tile->type);
+    
+    tile_destroy(tile);
+    s_tiles.tiles.erase(s_tiles.tiles.begin() + (tile - s_tiles.tiles.data()));
+    invalidate_tiles();
+
+    if(is_ground) {
+      TransitionStats stats = {};
+      sync_ground_colliders(&stats);
+    }
   }
 }
 
+void tile_manager_query_range(const AABB& range, nikola::DynamicArray<Tile*>& out_tiles) {
+  if(s_tiles.is_grid_dirty) {
+    index_tiles();
+  }
+
+  s_tiles.query_entities.clear();
+  spatial_grid_query_range(s_tiles.grid, range, s_tiles.query_entities);
+
+  // The grid only knows about entities
+  for(auto& entity : s_tiles.query_entities) {
+    out_tiles.push_back(&s_tiles.tiles[s_tiles.tile_indices[entity]]);
+  }
+}
+
+Tile* tile_manager_find_tile(const nikola::Vec3& position) {
+  // Anything right above or below the position counts
+  AABB column = {
+    .min = nikola::Vec3(position.x, -TILE_QUERY_DEPTH, position.z), 
+    .max = nikola::Vec3(position.x, TILE_QUERY_DEPTH, position.z),
+  };
+
+  s_tiles.query_tiles.clear();
+  tile_manager_query_range(column, s_tiles.query_tiles);
+
+  return s_tiles.query_tiles.empty() ? nullptr : s_tiles.query_tiles[0];
+}
+
 void tile_manager_render() {
-  nikola::ResourceID mesh_id  = resource_database_get(RESOURCE_CUBE);
   nikola::Transform transform = {}; 
 
-  // Render tiles
+  if(s_tiles.is_render_dirty) {
+    bake_render_groups();
+  }
 
-  for(auto& tile : s_tiles.tiles) {
-    transform = nikola::physics_body_get_transform(tile.entity.body);
+  // Render tiles (one draw per type)
 
-    switch(tile.type) {
-      case TILE_PAVIMENT:
-        nikola::transform_scale(transform, nikola::collider_get_extents(tile.entity.collider));
-        nikola::renderer_queue_mesh(mesh_id, transform, resource_database_get(RESOURCE_MATERIAL_PAVIMENT));
-        break;
-      case TILE_ROAD:
-        nikola::transform_scale(transform, nikola::collider_get_extents(tile.entity.collider));
-        nikola::renderer_queue_mesh(mesh_id, transform, resource_database_get(RESOURCE_MATERIAL_ROAD));
-        break;
-      case TILE_CONE:
-        nikola::transform_scale(transform, nikola::Vec3(4.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_CONE), transform);
-        break;
-      case TILE_TUNNEL_ONE_WAY:
-        nikola::transform_scale(transform, nikola::Vec3(1.5f, 2.0f, 1.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_TUNNEL), transform);
-        break;
-      case TILE_TUNNEL_TWO_WAY:
-        nikola::transform_scale(transform, nikola::Vec3(2.0f, 2.0f, 1.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_TUNNEL), transform);
-        break;
-      case TILE_TUNNEL_THREE_WAY:
-        nikola::transform_scale(transform, nikola::Vec3(3.0f, 2.0f, 1.0f));
-        nikola::renderer_queue_model(resource_database_get(RESOURCE_TUNNEL), transform);
-        break;
-      default:
-        break;
+  Level* lvl = s_tiles.level_ref;
+  for(auto& group : s_tiles.render_groups) {
+    group.visible.clear();
+
+    for(nikola::sizei i = 0; i < group.transforms.size(); i++) {
+      if(frustum_test_aabb(lvl->frustum, group.bounds[i])) {
+        group.visible.push_back(group.transforms[i]);
+      }
     }
-  
-    if(s_tiles.level_ref->debug_mode) {
-      nikola::renderer_debug_collider(tile.entity.collider, nikola::Vec3(1.0f, 0.0f, 1.0f));
+
+    lvl->culling_stats.visible += group.visible.size();
+    lvl->culling_stats.culled  += group.transforms.size() - group.visible.size();
+
+    if(group.visible.empty()) {
+      continue;
+    }
+
+    if(group.is_model) {
+      nikola::renderer_queue_model_instanced(group.resource_id, group.visible.data(), group.visible.size());
+    }
+    else {
+      nikola::renderer_queue_mesh_instanced(group.resource_id, group.visible.data(), group.visible.size(), group.material_id);
+    }
+  }
+
+  // Render the tile colliders
+  if(s_tiles.level_ref->debug_mode) {
+    for(auto& tile : s_tiles.tiles) {
+      if(tile.entity->collider) {
+        nikola::renderer_debug_collider(tile.entity->collider, nikola::Vec3(1.0f, 0.0f, 1.0f));
+      }
+    }
+  }
+
+  // Render the merged ground colliders
+  if(s_tiles.level_ref->debug_mode) {
+    for(auto& collider : s_tiles.ground_colliders) {
+      nikola::renderer_debug_collider(collider.entity->collider, nikola::Vec3(0.0f, 1.0f, 1.0f));
     }
   }
   
@@ -212,7 +806,13 @@ void tile_manager_render_gui() {
     ImGui::Text("Tiles count: %zu", s_tiles.tiles.size());
    
     if(ImGui::Button("Clear tiles")) {
+      for(auto& tile : s_tiles.tiles) {
+        tile_destroy(&tile);
+      }
+
       s_tiles.tiles.clear();
+      s_tiles.is_ground_dirty = true;
+      invalidate_tiles();
     }
     
     // Filter
@@ -227,44 +827,85 @@ void tile_manager_render_gui() {
       }
       
       nikola::String name = ("Tile " + std::to_string(i)); 
-      Entity* entity      = &s_tiles.tiles[i].entity;
+      Entity* entity      = s_tiles.tiles[i].entity;
       
       ImGui::SeparatorText(name.c_str());
       ImGui::PushID(name.c_str());
 
+      // Any change to a ground tile means the merged colliders are out of date
+      bool is_ground = tile_is_ground(s_tiles.tiles[i].type);
+
       // Position 
-      nikola::Vec3 position = nikola::physics_body_get_position(entity->body);
+      nikola::Vec3 position = entity->start_pos;
       if(ImGui::DragFloat3("Position", &position[0], 0.1f)) {
-        nikola::physics_body_set_position(entity->body, position);
         entity->start_pos = position;
+        
+        if(entity->body) {
+          nikola::physics_body_set_position(entity->body, position);
+        }
+        
+        s_tiles.is_ground_dirty |= is_ground;
+        s_tiles.is_render_dirty  = true;
+
+        spatial_grid_update(&s_tiles.grid, entity, get_tile_bounds(s_tiles.tiles[i]));
       }
       
-      // Collider extents
-      nikola::gui_edit_collider("Collider", entity->collider); 
-
-      // Rotation
-      float rotation = nikola::physics_body_get_rotation(entity->body).w * nikola::RAD2DEG;
-      if(ImGui::DragFloat("Rotation", &rotation, 45.0f)) {
-        nikola::physics_body_set_rotation(entity->body, nikola::Vec3(0.0f, 1.0f, 0.0f), rotation * nikola::DEG2RAD);
+      if(entity->body) {
+        // Collider extents
+        nikola::gui_edit_collider("Collider", entity->collider); 
+        
+        // Rotation
+        float rotation = nikola::physics_body_get_rotation(entity->body).w * nikola::RAD2DEG;
+        if(ImGui::DragFloat("Rotation", &rotation, 45.0f)) {
+          nikola::physics_body_set_rotation(entity->body, nikola::Vec3(0.0f, 1.0f, 0.0f), rotation * nikola::DEG2RAD);
+          s_tiles.is_render_dirty = true;
+        }
+      }
+      else if(ImGui::DragFloat3("Scale", &s_tiles.tiles[i].scale[0], 0.1f)) {
+        s_tiles.is_ground_dirty = true;
+        invalidate_tiles();
       }
 
       // Active 
-      ImGui::Checkbox("Active", &entity->is_active);
+      if(ImGui::Checkbox("Active", &entity->is_active)) {
+        s_tiles.is_ground_dirty |= is_ground;
+      }
 
       // Type
       int type = (int)s_tiles.tiles[i].type;
       if(ImGui::Combo("Type", &type, "Road\0Paviment\0Cone\0Tunnel (One way)\0Tunnel (Two way)\0Tunnel (Three way)\0\0")) {
-        s_tiles.tiles[i].type = (TileType)type;
+        // Every type has its own shape, and only the non-ground ones get a body. 
+        // Easier to just make the tile all over again.
+
+        bool is_active     = entity->is_active;
+        nikola::Vec3 floor = nikola::Vec3(entity->start_pos.x, 0.0f, entity->start_pos.z);
+
+        tile_destroy(&s_tiles.tiles[i]);
+        tile_create(&s_tiles.tiles[i], s_tiles.level_ref, (TileType)type, floor);
+        s_tiles.tiles[i].entity->is_active = is_active;
+
+        s_tiles.is_ground_dirty |= (is_ground || tile_is_ground((TileType)type));
+        invalidate_tiles();
       }
       
       // Remove the end point
       if(ImGui::Button("Remove")) {
+        tile_destroy(&s_tiles.tiles[i]);
         s_tiles.tiles.erase(s_tiles.tiles.begin() + i);
+        
+        s_tiles.is_ground_dirty |= is_ground;
+        invalidate_tiles();
       }
       
       ImGui::PopID();
     }
   }
+
+  // Catch the ground up with the edits
+  if(s_tiles.is_ground_dirty) {
+    TransitionStats stats = {};
+    sync_ground_colliders(&stats);
+  }
 }
 
 /// Tile manager functions
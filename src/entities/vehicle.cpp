@@ -5,67 +5,403 @@
 
 #include <nikola/nikola.h>
 
+#include <cfloat>
+#include <cmath>
+
 /// ----------------------------------------------------------------------
-/// Vehicle functions
+/// VehicleDesc
+struct VehicleDesc {
+  nikola::Vec3 collider_scale;
+  nikola::Vec3 collider_offset;
 
-void vehicle_create(Vehicle* v, 
-                    Level* lvl, 
-                    const VehicleType type, 
-                    const nikola::Vec3& start_pos, 
-                    const nikola::Vec3& dir,
-                    const float acceleration) {
-  nikola::Vec3 collider_scale, collider_offset; 
+  // Wide enough to not care about which way the vehicle is facing
+  AABB bounds;
+};
+/// VehicleDesc
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static VehicleDesc make_desc(const nikola::Vec3& collider_scale, const nikola::Vec3& collider_offset) {
+  float radius = nikola::vec3_length(nikola::Vec3(collider_scale.x, 0.0f, collider_scale.z)) / 2.0f;
 
+  return VehicleDesc {
+    .collider_scale  = collider_scale,
+    .collider_offset = collider_offset,
+    .bounds          = AABB {
+      .min = collider_offset - nikola::Vec3(radius, collider_scale.y / 2.0f, radius),
+      .max = collider_offset + nikola::Vec3(radius, collider_scale.y / 2.0f, radius),
+    },
+  };
+}
+
+static const VehicleDesc& get_desc(const VehicleType type) {
   // Each vehicle type has a different scale and collider offset
-  switch(type) {
-    case VEHICLE_CAR:
-      collider_scale  = nikola::Vec3(5.0f, 4.9f, 9.0f);
-      collider_offset = nikola::Vec3(0.0f, 2.5f, 0.0f);
-      break;
-    case VEHICLE_TRUCK:
-      collider_scale  = nikola::Vec3(7.5f, 8.0f, 17.0f);
-      collider_offset = nikola::Vec3(0.0f, 4.2f, 0.0f);
-      break;
+  static const VehicleDesc s_descs[VEHICLE_TYPES_MAX] = {
+    make_desc(nikola::Vec3(5.0f, 4.9f, 9.0f), nikola::Vec3(0.0f, 2.5f, 0.0f)),  // VEHICLE_CAR
+    make_desc(nikola::Vec3(7.5f, 8.0f, 17.0f), nikola::Vec3(0.0f, 4.2f, 0.0f)), // VEHICLE_TRUCK
+  };
+
+  return s_descs[type];
+}
+
+static nikola::PhysicsBodyType get_body_type(const VehicleStore& store) {
+  return store.is_kinematic ? nikola::PHYSICS_BODY_KINEMATIC : nikola::PHYSICS_BODY_DYNAMIC;
+}
+
+static float ray_aabb_test(const nikola::Vec3& origin, const nikola::Vec3& dir, const AABB& box) {
+  float enter = 0.0f; 
+  float exit  = FLT_MAX;
+
+  // Slab test. Only hits in front of the origin count.
+
+  for(nikola::sizei i = 0; i < 3; i++) {
+    if(dir[i] == 0.0f) {
+      if(origin[i] <= box.min[i] || origin[i] >= box.max[i]) {
+        return -1.0f;
+      }
+
+      continue;
+    }
+
+    float t0 = (box.min[i] - origin[i]) / dir[i];
+    float t1 = (box.max[i] - origin[i]) / dir[i];
+    if(t0 > t1) {
+      float temp = t0; 
+      t0         = t1; 
+      t1         = temp;
+    }
+
+    enter = t0 > enter ? t0 : enter;
+    exit  = t1 < exit ? t1 : exit;
+
+    if(enter > exit) {
+      return -1.0f;
+    }
   }
 
-  // Entity init
-  entity_create(&v->entity, 
-                lvl, 
-                start_pos, 
-                collider_scale,
-                ENTITY_VEHICLE, 
-                nikola::PHYSICS_BODY_DYNAMIC);
-
-  // Vehicle variables init 
-  v->type         = type; 
-  v->acceleration = acceleration;
-  v->direction    = dir;
-  v->rotation     = nikola::Vec4(0.0f);
+  return enter;
+}
 
+static nikola::Vec4 get_facing(const nikola::Vec3& dir) {
   // Based on the direction, the vehicle should be
-  // facing towards the correct direction. 
+  // facing towards the correct direction.
   if(dir.z <= -1) {
-    v->rotation = nikola::Vec4(0.0f, 1.0f, 0.0f, 180.0f * nikola::DEG2RAD);
-    nikola::physics_body_set_rotation(v->entity.body, nikola::Vec3(v->rotation), v->rotation.w);
-  } 
+    return nikola::Vec4(0.0f, 1.0f, 0.0f, 180.0f * nikola::DEG2RAD);
+  }
+
+  return nikola::Vec4(0.0f);
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Vehicle functions
+
+void vehicle_create(VehicleStore* store,
+                    const nikola::sizei index,
+                    Level* lvl,
+                    const VehicleType type,
+                    const nikola::Vec3& start_pos,
+                    const nikola::Vec3& dir,
+                    const float acceleration) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_create");
+  NIKOLA_ASSERT(index < store->count, "Out of range index given to vehicle_create");
+
+  const VehicleDesc& desc = get_desc(type);
+
+  // Entity init
+  Entity* entity = entity_create(lvl,
+                                 start_pos,
+                                 desc.collider_scale,
+                                 ENTITY_VEHICLE,
+                                 get_body_type(*store));
+  store->entities[index] = entity;
+
+  // Vehicle variables init
+  store->types[index]         = (nikola::u8)type;
+  store->accelerations[index] = acceleration;
+  store->directions[index]    = dir;
+  store->active[index]        = true;
+  store->spawn_times[index]   = store->clock;
+  store->lane_lengths[index]  = 0.0f;
+
+  nikola::Vec4 facing = get_facing(dir);
+  if(facing.w != 0.0f) {
+    nikola::physics_body_set_rotation(entity->body, nikola::Vec3(facing), facing.w);
+  }
 
   // Collider position init
-  nikola::collider_set_local_position(v->entity.collider, collider_offset);
+  nikola::collider_set_local_position(entity->collider, desc.collider_offset);
+
+  // Set the collision layer. Kinematic vehicles stay out of the 
+  // physics world entirely, since the player is tested against them directly.
+  nikola::physics_body_set_layers(entity->body, store->is_kinematic ? 0 : entity_get_physics_layers(ENTITY_VEHICLE));
+
+  // Nothing has been synced yet
+  store->transforms[index]         = nikola::physics_body_get_transform(entity->body);
+  store->previous_positions[index] = store->transforms[index].position;
+}
 
-  // Set the collision layer
-  nikola::physics_body_set_layers(v->entity.body, PHYSICS_LAYER_0);
+void vehicle_copy(VehicleStore* dest, const nikola::sizei dest_index, const VehicleStore& src, const nikola::sizei src_index) {
+  NIKOLA_ASSERT(dest, "Invalid store given to vehicle_copy");
+  NIKOLA_ASSERT(dest_index < dest->count && src_index < src.count, "Out of range index given to vehicle_copy");
+  NIKOLA_ASSERT(dest->is_kinematic == src.is_kinematic, "Cannot copy vehicles between different traffic modes");
+
+  dest->transforms[dest_index]         = src.transforms[src_index];
+  dest->previous_positions[dest_index] = src.previous_positions[src_index];
+  dest->directions[dest_index]         = src.directions[src_index];
+  dest->accelerations[dest_index]      = src.accelerations[src_index];
+  dest->types[dest_index]              = src.types[src_index];
+  dest->active[dest_index]             = src.active[src_index];
+  dest->spawn_times[dest_index]        = src.spawn_times[src_index];
+  dest->lane_lengths[dest_index]       = src.lane_lengths[src_index];
+  dest->entities[dest_index]           = src.entities[src_index];
+}
+
+void vehicle_destroy(VehicleStore* store, const nikola::sizei index) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_destroy");
+  entity_destroy(store->entities[index]);
+  store->entities[index] = nullptr;
 }
 
-void vehicle_set_active(Vehicle& v, const bool active) {
-  v.entity.is_active = active;
-  nikola::physics_body_set_awake(v.entity.body, active);
+void vehicle_set_active(VehicleStore* store, const nikola::sizei index, const bool active) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_set_active");
+
+  Entity* entity = store->entities[index];
 
-  if(active) {
-    nikola::physics_body_set_rotation(v.entity.body, nikola::Vec3(v.rotation), v.rotation.w);
-    nikola::physics_body_set_angular_velocity(v.entity.body, nikola::Vec3(0.0f));
-    nikola::physics_body_set_linear_velocity(v.entity.body, nikola::Vec3(v.acceleration) * v.direction);
+  // @NOTE: The physics callbacks only ever see the entity, so both flags have to agree
+  store->active[index] = active;
+  entity->is_active    = active;
+
+  nikola::physics_body_set_awake(entity->body, active);
+
+  if(!active) {
+    return;
+  }
+
+  nikola::Vec4 facing = get_facing(store->directions[index]);
+
+  nikola::physics_body_set_rotation(entity->body, nikola::Vec3(facing), facing.w);
+  nikola::physics_body_set_angular_velocity(entity->body, nikola::Vec3(0.0f));
+
+  // Kinematic vehicles get moved by `vehicle_store_update` instead
+  
+  if(store->is_kinematic) {
+    store->spawn_times[index] = store->clock;
+    nikola::physics_body_set_linear_velocity(entity->body, nikola::Vec3(0.0f));
+  }
+  else {
+    nikola::physics_body_set_linear_velocity(entity->body, nikola::Vec3(store->accelerations[index]) * store->directions[index]);
   }
 }
 
+const AABB& vehicle_get_bounds(const VehicleType type) {
+  return get_desc(type).bounds;
+}
+
+const AABB vehicle_get_collider_box(const VehicleType type) {
+  const VehicleDesc& desc = get_desc(type);
+
+  // Vehicles only ever turn around, so the box is the same both ways
+  return AABB {
+    .min = desc.collider_offset - (desc.collider_scale / 2.0f),
+    .max = desc.collider_offset + (desc.collider_scale / 2.0f),
+  };
+}
+
+const float vehicle_get_lane_length(const VehicleType type, 
+                                    const nikola::Vec3& start_pos, 
+                                    const nikola::Vec3& dir, 
+                                    const nikola::DynamicArray<AABB>& stops) {
+  /// @NOTE: A lane runs from a vehicle's start position up until its collider
+  /// would first touch one of the `stops`. The length is in units of the direction, 
+  /// so `acceleration * time` can be wrapped around it directly. 
+
+  const VehicleDesc& desc   = get_desc(type);
+  nikola::Vec3 origin       = start_pos + desc.collider_offset;
+  nikola::Vec3 half_extents = desc.collider_scale / 2.0f;
+
+  float closest = -1.0f;
+  for(auto& stop : stops) {
+    // Grow the stop by the vehicle's collider and treat the vehicle as a ray
+    
+    AABB box  = AABB{stop.min - half_extents, stop.max + half_extents};
+    float hit = ray_aabb_test(origin, dir, box);
+    
+    if(hit > 0.0f && (closest < 0.0f || hit < closest)) {
+      closest = hit;
+    }
+  }
+
+  // Never wraps around if nothing is in the way
+  return closest > 0.0f ? closest : 0.0f;
+}
+
+const float vehicle_get_lane_distance(const float acceleration, const float lane_length, const nikola::f64 time) {
+  nikola::f64 distance = acceleration * time;
+  if(lane_length > 0.0f) {
+    distance = fmod(distance, (nikola::f64)lane_length);
+  }
+
+  return (float)distance;
+}
+
 /// Vehicle functions
 /// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// VehicleStore functions
+
+void vehicle_store_resize(VehicleStore* store, const nikola::sizei count) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_resize");
+
+  store->count = count;
+
+  store->transforms.resize(count);
+  store->previous_positions.resize(count);
+  store->directions.resize(count);
+  store->accelerations.resize(count);
+  store->types.resize(count);
+  store->active.resize(count);
+  store->spawn_times.resize(count);
+  store->lane_lengths.resize(count);
+  store->entities.resize(count);
+}
+
+void vehicle_store_remove(VehicleStore* store, const nikola::sizei index) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_remove");
+  NIKOLA_ASSERT(index < store->count, "Out of range index given to vehicle_store_remove");
+
+  vehicle_destroy(store, index);
+
+  store->transforms.erase(store->transforms.begin() + index);
+  store->previous_positions.erase(store->previous_positions.begin() + index);
+  store->directions.erase(store->directions.begin() + index);
+  store->accelerations.erase(store->accelerations.begin() + index);
+  store->types.erase(store->types.begin() + index);
+  store->active.erase(store->active.begin() + index);
+  store->spawn_times.erase(store->spawn_times.begin() + index);
+  store->lane_lengths.erase(store->lane_lengths.begin() + index);
+  store->entities.erase(store->entities.begin() + index);
+
+  store->count--;
+}
+
+void vehicle_store_clear(VehicleStore* store) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_clear");
+
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    vehicle_destroy(store, i);
+  }
+
+  vehicle_store_resize(store, 0);
+}
+
+void vehicle_store_set_kinematic(VehicleStore* store, const bool kinematic) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_set_kinematic");
+
+  if(store->is_kinematic == kinematic) {
+    return;
+  }
+
+  // Every body has to be swapped for one of the other type
+
+  store->is_kinematic = kinematic;
+
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    Entity old_entity = *store->entities[i];
+    vehicle_destroy(store, i);
+
+    vehicle_create(store, 
+                   i, 
+                   old_entity.level_ref, 
+                   (VehicleType)store->types[i], 
+                   old_entity.start_pos, 
+                   store->directions[i], 
+                   store->accelerations[i]);
+    
+    vehicle_set_active(store, i, old_entity.is_active);
+  }
+}
+
+void vehicle_store_build_lanes(VehicleStore* store, const nikola::DynamicArray<Entity*>& points) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_build_lanes");
+
+  // Only vehicle points send vehicles back to the start
+
+  nikola::DynamicArray<AABB> stops;
+  for(auto& point : points) {
+    if(point->type != ENTITY_VEHICLE_POINT) {
+      continue;
+    }
+
+    nikola::Vec3 point_extents = nikola::collider_get_extents(point->collider) / 2.0f;
+    stops.push_back(AABB{point->start_pos - point_extents, point->start_pos + point_extents});
+  }
+
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    store->lane_lengths[i] = vehicle_get_lane_length((VehicleType)store->types[i], 
+                                                     store->entities[i]->start_pos, 
+                                                     store->directions[i], 
+                                                     stops);
+  }
+}
+
+void vehicle_store_update(VehicleStore* store, const float delta_time) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_update");
+
+  store->clock += delta_time;
+
+  // Rendering goes in between where the vehicles were and where they are now
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    store->previous_positions[i] = store->transforms[i].position;
+  }
+
+  // Dynamic vehicles were moved by the physics world. Just catch up with it.
+  if(!store->is_kinematic) {
+    for(nikola::sizei i = 0; i < store->count; i++) {
+      store->transforms[i] = nikola::physics_body_get_transform(store->entities[i]->body);
+    }
+
+    return;
+  }
+
+  // Everything else only depends on the time spent on the lane
+
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    if(!store->active[i]) {
+      continue;
+    }
+
+    nikola::f64 time    = store->clock - store->spawn_times[i];
+    float distance      = vehicle_get_lane_distance(store->accelerations[i], store->lane_lengths[i], time);
+    float last_distance = vehicle_get_lane_distance(store->accelerations[i], store->lane_lengths[i], time - delta_time);
+
+    Entity* entity                = store->entities[i];
+    store->transforms[i].position = entity->start_pos + store->directions[i] * distance;
+    
+    nikola::physics_body_set_position(entity->body, store->transforms[i].position);
+
+    // Wrapped around. Do not draw it sliding all the way back.
+    if(distance < last_distance) {
+      store->previous_positions[i] = store->transforms[i].position;
+    }
+  }
+}
+
+void vehicle_store_sync(VehicleStore* store) {
+  NIKOLA_ASSERT(store, "Invalid store given to vehicle_store_sync");
+
+  // Anything that got teleported should not be drawn moving there 
+
+  for(nikola::sizei i = 0; i < store->count; i++) {
+    store->transforms[i]         = nikola::physics_body_get_transform(store->entities[i]->body);
+    store->previous_positions[i] = store->transforms[i].position;
+  }
+}
+
+/// VehicleStore functions
+/// ----------------------------------------------------------------------
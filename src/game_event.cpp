@@ -1,20 +1,95 @@
 #include "game_event.h"
 
+#include <nikola/nikola.h>
 #include <nikola/nikola_containers.h>
 
+#include <atomic>
+#include <cstdint>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+// Has to be a power of 2
+const nikola::sizei GAME_EVENT_QUEUE_CAPACITY = 256;
+
+const nikola::u32 INVALID_SLOT = (nikola::u32)-1;
+
+// Firing any of these more than once a frame does nothing useful
+const bool GAME_EVENT_COALESCE[GAME_EVENTS_MAX] = {
+  true,  // GAME_EVENT_STATE_CHANGED
+  false, // GAME_EVENT_COIN_COLLECTED
+  true,  // GAME_EVENT_SOUND_PLAYED
+  true,  // GAME_EVENT_MUSIC_PLAYED
+  false, // GAME_EVENT_CHAPTER_ENTERED
+  false, // GAME_EVENT_CHAPTER_EXITED
+  false, // GAME_EVENT_LEVEL_PREFETCHED
+};
+
+/// Consts
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// GameEventEntry 
 struct GameEventEntry {
   OnGameEventFireFunc func; 
   void* listener;
+
+  nikola::u32 slot;
 };
 /// GameEventEntry 
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// GameEventSlot 
+struct GameEventSlot {
+  GameEventType type;
+  nikola::u32 index; // Into `events[type]` while alive, the next free slot otherwise
+  nikola::u32 generation;
+};
+/// GameEventSlot 
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// QueuedGameEvent 
+struct QueuedGameEvent {
+  GameEvent event; 
+  void* dispatcher;
+};
+/// QueuedGameEvent 
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GameEventCell 
+struct GameEventCell {
+  // Relative to the cell's index, so a zeroed out queue is ready to go
+  std::atomic<nikola::sizei> sequence; 
+  
+  QueuedGameEvent queued;
+};
+/// GameEventCell 
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// GameEventPool
 struct GameEventPool {
   nikola::DynamicArray<GameEventEntry> events[GAME_EVENTS_MAX];
+
+  // Listener tokens
+
+  nikola::DynamicArray<GameEventSlot> slots;
+  nikola::u32 free_slot = INVALID_SLOT;
+
+  nikola::u32 fire_depth = 0;
+  nikola::DynamicArray<GameEventToken> pending_removals;
+
+  // Queued mode
+
+  bool is_queued = false;
+  
+  GameEventCell queue[GAME_EVENT_QUEUE_CAPACITY];
+  
+  std::atomic<nikola::sizei> enqueue_pos; // Any thread
+  nikola::sizei dequeue_pos;              // Main thread only
 };
 
 static GameEventPool s_pool;
@@ -22,21 +97,254 @@ static GameEventPool s_pool;
 /// ----------------------------------------------------------------------
 
 /// ----------------------------------------------------------------------
-/// GameEvent functions
+/// Private functions
 
-void game_event_listen(const GameEventType type, const OnGameEventFireFunc& func, const void* listener) {
-  s_pool.events[type].push_back(GameEventEntry{});
-  GameEventEntry* entry = &s_pool.events[type][s_pool.events[type].size() - 1];
+static GameEventSlot* get_slot(const GameEventToken& token) {
+  if(token.slot >= s_pool.slots.size()) {
+    return nullptr;
+  }
 
-  NIKOLA_ASSERT(func, "Cannot listen to an event with an invalid callback");
-  entry->func     = func; 
-  entry->listener = (void*)listener;
+  GameEventSlot* slot = &s_pool.slots[token.slot];
+  return (slot->generation == token.generation) ? slot : nullptr;
 }
 
-void game_event_dispatch(const GameEvent& event, const void* dispatcher) {
+static void remove_listener(const GameEventToken& token) {
+  GameEventSlot* slot = get_slot(token);
+  if(!slot) { // Already gone
+    return;
+  }
+
+  // Swap the last entry into the hole, so the array stays packed
+
+  nikola::DynamicArray<GameEventEntry>& entries = s_pool.events[slot->type];
+  
+  GameEventEntry* last = &entries[entries.size() - 1];
+  s_pool.slots[last->slot].index = slot->index;
+  
+  entries[slot->index] = *last;
+  entries.pop_back();
+
+  // Skipping zero, since a default token should never be valid
+  slot->generation++;
+  if(slot->generation == 0) {
+    slot->generation = 1;
+  }
+
+  slot->index      = s_pool.free_slot;
+  s_pool.free_slot = token.slot;
+}
+
+static void fire_event(const GameEvent& event, void* dispatcher) {
+  s_pool.fire_depth++;
+  
   for(nikola::sizei i = 0; i < s_pool.events[event.type].size(); i++) {
     GameEventEntry* entry = &s_pool.events[event.type][i];
-    entry->func(event, (void*)dispatcher, entry->listener);
+    
+    // Unlistened while firing, and waiting to be removed
+    if(!entry->func) {
+      continue;
+    }
+
+    entry->func(event, dispatcher, entry->listener);
+  }
+
+  s_pool.fire_depth--;
+  if(s_pool.fire_depth > 0) {
+    return;
+  }
+
+  for(auto& token : s_pool.pending_removals) {
+    remove_listener(token);
+  }
+  s_pool.pending_removals.clear();
+}
+
+static bool is_same_event(const QueuedGameEvent& a, const QueuedGameEvent& b) {
+  return a.event.type        == b.event.type        && 
+         a.event.sound_type  == b.event.sound_type  && 
+         a.event.state_type  == b.event.state_type  && 
+         a.event.group_index == b.event.group_index && 
+         a.dispatcher        == b.dispatcher;
+}
+
+static void push_event(const GameEvent& event, const void* dispatcher) {
+  /*
+   * @NOTE:
+   *
+   * A bounded multi-producer, single-consumer queue. Producers claim a position with 
+   * a CAS on `enqueue_pos`, and each cell's sequence says whether it is free to be 
+   * written (== position), ready to be read (== position + 1) or still waiting on 
+   * the consumer (anything behind). No thread ever waits on another one.
+   *
+   */
+
+  nikola::sizei pos = s_pool.enqueue_pos.load(std::memory_order_relaxed);
+  GameEventCell* cell;
+
+  while(true) {
+    nikola::sizei index = pos & (GAME_EVENT_QUEUE_CAPACITY - 1);
+    cell                = &s_pool.queue[index];
+
+    nikola::sizei sequence = cell->sequence.load(std::memory_order_acquire) + index;
+    intptr_t diff          = (intptr_t)sequence - (intptr_t)pos;
+
+    if(diff == 0) {
+      if(s_pool.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    else if(diff < 0) {
+      NIKOLA_LOG_WARN("Game event queue is full. Dropping event %i", event.type);
+      return;
+    }
+    else {
+      pos = s_pool.enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->queued = QueuedGameEvent{event, (void*)dispatcher};
+  cell->sequence.store((pos + 1) - (pos & (GAME_EVENT_QUEUE_CAPACITY - 1)), std::memory_order_release);
+}
+
+static bool pop_event(QueuedGameEvent* out_event) {
+  nikola::sizei pos   = s_pool.dequeue_pos;
+  nikola::sizei index = pos & (GAME_EVENT_QUEUE_CAPACITY - 1);
+  GameEventCell* cell = &s_pool.queue[index];
+
+  // Not written yet (or not even claimed)
+  nikola::sizei sequence = cell->sequence.load(std::memory_order_acquire) + index;
+  if(sequence != (pos + 1)) {
+    return false;
+  }
+
+  *out_event = cell->queued;
+  
+  // Free for whoever comes around the ring next
+  cell->sequence.store((pos + GAME_EVENT_QUEUE_CAPACITY) - index, std::memory_order_release);
+  s_pool.dequeue_pos++;
+
+  return true;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GameEvent functions
+
+const GameEventToken game_event_listen(const GameEventType type, 
+                                       const OnGameEventFireFunc& func, 
+                                       const void* listener, 
+                                       GameEventScope* scope) {
+  NIKOLA_ASSERT(func, "Cannot listen to an event with an invalid callback");
+
+  // Reuse a dead slot if there is one
+  
+  GameEventToken token;
+  if(s_pool.free_slot != INVALID_SLOT) {
+    token.slot       = s_pool.free_slot;
+    s_pool.free_slot = s_pool.slots[token.slot].index;
+  }
+  else {
+    token.slot = (nikola::u32)s_pool.slots.size();
+    s_pool.slots.push_back(GameEventSlot{type, 0, 1});
+  }
+  
+  GameEventSlot* slot = &s_pool.slots[token.slot];
+  slot->type          = type;
+  slot->index         = (nikola::u32)s_pool.events[type].size();
+  token.generation    = slot->generation;
+
+  s_pool.events[type].push_back(GameEventEntry{func, (void*)listener, token.slot});
+
+  if(scope) {
+    scope->tokens.push_back(token);
+  }
+
+  return token;
+}
+
+void game_event_unlisten(const GameEventToken& token) {
+  // Removing now would shuffle the entries under the listeners that are still firing. 
+  // The entry still has to stop firing right away, though, since its listener might 
+  // not be around anymore.
+  
+  if(s_pool.fire_depth > 0) {
+    GameEventSlot* slot = get_slot(token);
+    if(slot) {
+      s_pool.events[slot->type][slot->index].func = nullptr;
+      s_pool.pending_removals.push_back(token);
+    }
+
+    return;
+  }
+
+  remove_listener(token);
+}
+
+void game_event_scope_clear(GameEventScope* scope) {
+  NIKOLA_ASSERT(scope, "Invalid scope given to game_event_scope_clear");
+
+  for(auto& token : scope->tokens) {
+    game_event_unlisten(token);
+  }
+  scope->tokens.clear();
+}
+
+void game_event_dispatch(const GameEvent& event, const void* dispatcher) {
+  // Straight to the listeners, unless queued mode was turned on
+  if(s_pool.is_queued) {
+    push_event(event, dispatcher);
+    return;
+  }
+
+  fire_event(event, (void*)dispatcher);
+}
+
+void game_event_post(const GameEvent& event) {
+  // Always waits for the next flush, no matter the mode. Safe from any thread.
+  push_event(event, nullptr);
+}
+
+void game_event_set_queued(const bool queued) {
+  // Nothing should be left behind when going back
+  if(!queued) {
+    game_event_flush();
+  }
+
+  s_pool.is_queued = queued;
+}
+
+void game_event_flush() {
+  /// @NOTE: Only everything that was in the queue when the batch started gets 
+  /// coalesced. Events dispatched by the listeners go out in the next batch, 
+  /// but still within this same flush.
+  ///
+  /// Any `dispatcher` given to a queued event has to outlive the frame.
+
+  nikola::DynamicArray<QueuedGameEvent> batch;
+
+  while(true) {
+    QueuedGameEvent queued;
+    while(pop_event(&queued)) {
+      bool is_duplicate = false;
+      for(nikola::sizei i = 0; i < batch.size() && GAME_EVENT_COALESCE[queued.event.type]; i++) {
+        is_duplicate |= is_same_event(batch[i], queued);
+      }
+
+      if(!is_duplicate) {
+        batch.push_back(queued);
+      }
+    }
+
+    if(batch.empty()) {
+      break;
+    }
+
+    for(auto& event : batch) {
+      fire_event(event.event, event.dispatcher);
+    }
+    batch.clear();
   }
 }
 
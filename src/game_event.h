@@ -1,5 +1,7 @@
 #pragma once
 
+#include <nikola/nikola.h>
+
 /// ----------------------------------------------------------------------
 /// GameEventType
 enum GameEventType {
@@ -9,8 +11,9 @@ enum GameEventType {
   GAME_EVENT_MUSIC_PLAYED,
   GAME_EVENT_CHAPTER_ENTERED,
   GAME_EVENT_CHAPTER_EXITED,
+  GAME_EVENT_LEVEL_PREFETCHED,
 
-  GAME_EVENTS_MAX = GAME_EVENT_CHAPTER_EXITED + 1,
+  GAME_EVENTS_MAX = GAME_EVENT_LEVEL_PREFETCHED + 1,
 };
 /// GameEventType
 /// ----------------------------------------------------------------------
@@ -22,10 +25,28 @@ struct GameEvent {
 
   int sound_type;
   int state_type;
+  int group_index; // Chapter events only
 };
 /// GameEvent
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// GameEventToken
+struct GameEventToken {
+  nikola::u32 slot       = 0;
+  nikola::u32 generation = 0; // A zero generation is never handed out
+};
+/// GameEventToken
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// GameEventScope
+struct GameEventScope {
+  nikola::DynamicArray<GameEventToken> tokens;
+};
+/// GameEventScope
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Callbacks
 
@@ -37,9 +58,22 @@ using OnGameEventFireFunc = void(*)(const GameEvent& event, void* dispatcher, vo
 /// ----------------------------------------------------------------------
 /// GameEvent functions
 
-void game_event_listen(const GameEventType type, const OnGameEventFireFunc& func, const void* listener = nullptr);
+const GameEventToken game_event_listen(const GameEventType type, 
+                                       const OnGameEventFireFunc& func, 
+                                       const void* listener = nullptr, 
+                                       GameEventScope* scope = nullptr);
+
+void game_event_unlisten(const GameEventToken& token);
+
+void game_event_scope_clear(GameEventScope* scope);
 
 void game_event_dispatch(const GameEvent& event, const void* dispatcher = nullptr);
 
+void game_event_post(const GameEvent& event);
+
+void game_event_set_queued(const bool queued);
+
+void game_event_flush();
+
 /// GameEvent functions
 /// ----------------------------------------------------------------------
@@ -1,8 +1,83 @@
 #include "input_manager.h"
+#include "levels/level.h"
 
+#include <nikola/nikola.h>
 #include <nikola/nikola_math.h>
 #include <nikola/nikola_input.h>
 
+#include <cstring>
+#include <cmath>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::u8 NKREPLAY_VERSION_MAJOR = 0; 
+const nikola::u8 NKREPLAY_VERSION_MINOR = 1; 
+
+// Delta times are stored in tenths of a millisecond
+const float REPLAY_DELTA_UNITS = 10000.0f;
+
+// Movement axises are stored as signed bytes
+const float REPLAY_MOVEMENT_UNITS = 127.0f;
+
+// How many identical frames a single record can stand in for
+const nikola::u8 REPLAY_REPEAT_MAX = 31;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// InputFrameFlags
+enum InputFrameFlags {
+  INPUT_FRAME_MOVEMENT = 1 << 0, 
+  INPUT_FRAME_ACTIONS  = 1 << 1, 
+  INPUT_FRAME_DELTA    = 1 << 2,
+
+  // Whatever is left of the flags byte is the repeat count
+  INPUT_FRAME_FLAGS_MASK   = 0x07,
+  INPUT_FRAME_REPEAT_SHIFT = 3,
+};
+/// InputFrameFlags
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// InputFrame
+struct InputFrame {
+  nikola::i8 movement_x = 0; 
+  nikola::i8 movement_z = 0;
+  nikola::u8 actions    = 0;
+  nikola::u32 delta     = 0; // In `REPLAY_DELTA_UNITS`
+};
+/// InputFrame
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// InputManager
+struct InputManager {
+  InputMode mode = INPUT_MODE_LIVE;
+
+  // The input of this frame, whether it came from the devices or from a replay
+
+  nikola::Vec3 movement = nikola::Vec3(0.0f);
+  nikola::u8 actions    = 0;
+  float delta_time      = 0.0f;
+
+  // Replay data
+  
+  nikola::FilePath replay_path;
+  nikola::DynamicArray<nikola::u8> replay_data;
+  nikola::sizei replay_offset = 0;
+  nikola::u32 frames_count    = 0;
+
+  InputFrame last_frame;
+  nikola::sizei last_record  = 0; // Offset of the last record's flags byte 
+  nikola::u8 repeats_left    = 0;
+};
+
+static InputManager s_input;
+/// InputManager
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Private functions
 
@@ -78,26 +153,332 @@ static const nikola::Vec3 get_gamepad_movement_velocity() {
   return nikola::Vec3(-x, 0.0f, z);
 }
 
+static InputFrame sample_devices(const float delta_time) {
+  InputFrame frame = {};
+  bool has_gamepad = nikola::input_gamepad_connected(nikola::JOYSTICK_ID_0);
+
+  // Movement
+  
+  nikola::Vec3 movement = has_gamepad ? get_gamepad_movement_velocity() : get_key_movement_velocity();
+  frame.movement_x      = (nikola::i8)roundf(nikola::clamp_float(movement.x, -1.0f, 1.0f) * REPLAY_MOVEMENT_UNITS);
+  frame.movement_z      = (nikola::i8)roundf(nikola::clamp_float(movement.z, -1.0f, 1.0f) * REPLAY_MOVEMENT_UNITS);
+
+  // Actions
+
+  for(nikola::u8 i = 0; i < INPUT_ACTIONS_MAX; i++) {
+    bool pressed = has_gamepad ? get_gamepad_action_pressed((InputAction)i) : get_key_action_pressed((InputAction)i);
+    frame.actions |= (pressed << i);
+  }
+
+  // Delta time
+  frame.delta = (nikola::u32)roundf(delta_time * REPLAY_DELTA_UNITS);
+
+  return frame;
+}
+
+static void apply_frame(const InputFrame& frame) {
+  s_input.movement   = nikola::Vec3(frame.movement_x / REPLAY_MOVEMENT_UNITS, 0.0f, frame.movement_z / REPLAY_MOVEMENT_UNITS);
+  s_input.actions    = frame.actions;
+  s_input.delta_time = frame.delta / REPLAY_DELTA_UNITS;
+}
+
+static void write_varint(nikola::DynamicArray<nikola::u8>& data, nikola::u32 value) {
+  while(value >= 0x80) {
+    data.push_back((nikola::u8)(value | 0x80));
+    value >>= 7;
+  }
+
+  data.push_back((nikola::u8)value);
+}
+
+static const bool read_varint(const nikola::DynamicArray<nikola::u8>& data, nikola::sizei* offset, nikola::u32* value) {
+  *value = 0;
+
+  for(nikola::u32 shift = 0; shift < 35; shift += 7) {
+    if(*offset >= data.size()) {
+      return false;
+    }
+
+    nikola::u8 byte = data[(*offset)++];
+    *value         |= (nikola::u32)(byte & 0x7f) << shift;
+
+    if((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void encode_frame(const InputFrame& frame) {
+  InputFrame& last = s_input.last_frame;
+  nikola::DynamicArray<nikola::u8>& data = s_input.replay_data;
+
+  nikola::u8 flags = 0; 
+  if(frame.movement_x != last.movement_x || frame.movement_z != last.movement_z) {
+    flags |= INPUT_FRAME_MOVEMENT;
+  }
+  if(frame.actions != last.actions) {
+    flags |= INPUT_FRAME_ACTIONS;
+  }
+  if(frame.delta != last.delta) {
+    flags |= INPUT_FRAME_DELTA;
+  }
+
+  s_input.frames_count++;
+
+  // Nothing changed? Just repeat the last record then.
+
+  bool has_record = s_input.last_record < data.size();
+  if(flags == 0 && has_record) {
+    nikola::u8& record = data[s_input.last_record];
+    if((record >> INPUT_FRAME_REPEAT_SHIFT) < REPLAY_REPEAT_MAX) {
+      record += (1 << INPUT_FRAME_REPEAT_SHIFT);
+      return;
+    }
+  }
+
+  // Only write what changed since the last frame
+
+  s_input.last_record = data.size();
+  data.push_back(flags);
+
+  if(flags & INPUT_FRAME_MOVEMENT) {
+    data.push_back((nikola::u8)frame.movement_x);
+    data.push_back((nikola::u8)frame.movement_z);
+  }
+
+  if(flags & INPUT_FRAME_ACTIONS) {
+    data.push_back(frame.actions);
+  }
+
+  if(flags & INPUT_FRAME_DELTA) {
+    write_varint(data, frame.delta);
+  }
+
+  last = frame;
+}
+
+static const bool decode_frame(InputFrame* frame) {
+  // Still repeating the last record
+  
+  if(s_input.repeats_left > 0) {
+    s_input.repeats_left--;
+    
+    *frame = s_input.last_frame;
+    return true;
+  }
+
+  const nikola::DynamicArray<nikola::u8>& data = s_input.replay_data;
+  nikola::sizei* offset                        = &s_input.replay_offset;
+  
+  if(*offset >= data.size()) {
+    return false;
+  }
+
+  nikola::u8 flags     = data[(*offset)++];
+  s_input.repeats_left = flags >> INPUT_FRAME_REPEAT_SHIFT;
+
+  InputFrame next = s_input.last_frame;
+
+  if(flags & INPUT_FRAME_MOVEMENT) {
+    if((*offset + 2) > data.size()) {
+      return false;
+    }
+
+    next.movement_x = (nikola::i8)data[(*offset)++];
+    next.movement_z = (nikola::i8)data[(*offset)++];
+  }
+
+  if(flags & INPUT_FRAME_ACTIONS) {
+    if(*offset >= data.size()) {
+      return false;
+    }
+
+    next.actions = data[(*offset)++];
+  }
+
+  if((flags & INPUT_FRAME_DELTA) && !read_varint(data, offset, &next.delta)) {
+    return false;
+  }
+
+  s_input.last_frame = next;
+  *frame             = next;
+
+  return true;
+}
+
+static void reset_replay_state() {
+  s_input.replay_data.clear();
+  s_input.replay_offset = 0;
+  s_input.frames_count  = 0;
+  s_input.last_frame    = {};
+  s_input.last_record   = 0;
+  s_input.repeats_left  = 0;
+}
+
 /// Private functions
 /// ----------------------------------------------------------------------
 
 /// ----------------------------------------------------------------------
 /// Input manager functions
 
-const bool input_manager_action_pressed(const InputAction action) {
-  if(nikola::input_gamepad_connected(nikola::JOYSTICK_ID_0)) {
-    return get_gamepad_action_pressed(action);
+void input_manager_update(const float delta_time) {
+  InputFrame frame;
+
+  switch(s_input.mode) {
+    case INPUT_MODE_LIVE:
+      // No need to round anything off when no one's listening
+      
+      s_input.movement = nikola::input_gamepad_connected(nikola::JOYSTICK_ID_0) ? get_gamepad_movement_velocity() : get_key_movement_velocity();
+      s_input.delta_time = delta_time;
+      
+      frame           = sample_devices(delta_time);
+      s_input.actions = frame.actions;
+      break;
+    case INPUT_MODE_RECORD:
+      // The game has to see the exact same (rounded) input the replay will
+      frame = sample_devices(delta_time);
+      
+      encode_frame(frame);
+      apply_frame(frame);
+      break;
+    case INPUT_MODE_REPLAY:
+      if(decode_frame(&frame)) {
+        apply_frame(frame);
+        break;
+      }
+     
+      // Back to the devices once the replay runs out
+      
+      NIKOLA_LOG_INFO("Replay '%s' finished", s_input.replay_path.c_str());
+      input_manager_replay_end();
+      input_manager_update(delta_time);
+      break;
   }
+}
 
-  return get_key_action_pressed(action);
+const bool input_manager_action_pressed(const InputAction action) {
+  return (s_input.actions >> action) & 1;
 }
 
 const nikola::Vec3 input_manager_get_movement_velocity() {
-  if(nikola::input_gamepad_connected(nikola::JOYSTICK_ID_0)) {
-    return get_gamepad_movement_velocity();
+  return s_input.movement;
+}
+
+const float input_manager_get_delta_time() {
+  return s_input.delta_time;
+}
+
+const InputMode input_manager_get_mode() {
+  return s_input.mode;
+}
+
+const bool input_manager_record_begin(const nikola::FilePath& path) {
+  input_manager_record_end();
+  input_manager_replay_end();
+
+  reset_replay_state();
+  
+  // Start off with a record every frame can be compared against 
+  s_input.last_record = (nikola::sizei)-1;
+
+  s_input.replay_path = path;
+  s_input.mode        = INPUT_MODE_RECORD;
+
+  NIKOLA_LOG_INFO("Recording input to '%s'", path.c_str());
+  return true;
+}
+
+void input_manager_record_end() {
+  if(s_input.mode != INPUT_MODE_RECORD) {
+    return;
+  }
+  s_input.mode = INPUT_MODE_LIVE;
+
+  nikola::File file;
+  if(!nikola::file_open(&file, s_input.replay_path, (int)(nikola::FILE_OPEN_WRITE | nikola::FILE_OPEN_BINARY))) {
+    NIKOLA_LOG_ERROR("Failed to save the replay file at '%s'", s_input.replay_path.c_str());
+    
+    reset_replay_state();
+    return;
+  }
+
+  NKReplayHeader header = {
+    .magic         = {'N', 'K', 'R', 'P'},
+    .major_version = NKREPLAY_VERSION_MAJOR, 
+    .minor_version = NKREPLAY_VERSION_MINOR,
+    .reserved      = 0,
+    .frames_count  = s_input.frames_count,
+    .data_size     = (nikola::u32)s_input.replay_data.size(),
+  };
+
+  nikola::file_write_bytes(file, &header, sizeof(header));
+  nikola::file_write_bytes(file, s_input.replay_data.data(), s_input.replay_data.size());
+  nikola::file_close(file);
+  
+  NIKOLA_LOG_INFO("Saved %u frames of input (%zu bytes) to '%s'", 
+                  header.frames_count, 
+                  s_input.replay_data.size(), 
+                  s_input.replay_path.c_str());
+  
+  reset_replay_state();
+}
+
+const bool input_manager_replay_begin(const nikola::FilePath& path) {
+  input_manager_record_end();
+  input_manager_replay_end();
+
+  /// @NOTE: The replay gets mapped (just like the levels) so the header can be 
+  /// checked against the actual size of the file before anything gets read.
+
+  NKFileMapping mapping;
+  if(!file_mapping_open(&mapping, path)) {
+    NIKOLA_LOG_ERROR("Failed to open the replay file at '%s'", path.c_str());
+    return false;
+  }
+
+  NKReplayHeader header = {};
+  bool is_valid         = mapping.size >= sizeof(NKReplayHeader);
+
+  if(is_valid) {
+    memcpy(&header, mapping.data, sizeof(NKReplayHeader));
+    
+    is_valid = (strncmp(header.magic, "NKRP", sizeof(header.magic)) == 0) && 
+               (header.major_version == NKREPLAY_VERSION_MAJOR)            && 
+               (header.minor_version == NKREPLAY_VERSION_MINOR)            && 
+               (header.data_size == (mapping.size - sizeof(NKReplayHeader)));
+  }
+  
+  if(!is_valid) {
+    NIKOLA_LOG_ERROR("Invalid replay file at '%s'", path.c_str());
+    
+    file_mapping_close(&mapping);
+    return false;
+  }
+
+  reset_replay_state();
+  
+  const nikola::u8* data = mapping.data + sizeof(NKReplayHeader);
+  s_input.replay_data.assign(data, data + header.data_size);
+  
+  file_mapping_close(&mapping);
+
+  s_input.frames_count = header.frames_count;
+  s_input.replay_path  = path;
+  s_input.mode         = INPUT_MODE_REPLAY;
+
+  NIKOLA_LOG_INFO("Replaying %u frames of input from '%s'", header.frames_count, path.c_str());
+  return true;
+}
+
+void input_manager_replay_end() {
+  if(s_input.mode != INPUT_MODE_REPLAY) {
+    return;
   }
 
-  return get_key_movement_velocity();
+  s_input.mode = INPUT_MODE_LIVE;
+  reset_replay_state();
 }
 
 /// Input manager functions
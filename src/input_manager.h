@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nikola/nikola_math.h>
+#include <nikola/nikola.h>
 
 /// ----------------------------------------------------------------------
 /// InputAction
@@ -12,16 +13,57 @@ enum InputAction {
   INPUT_ACTION_NAVIGATE_DOWN,
   INPUT_ACTION_NAVIGATE_LEFT,
   INPUT_ACTION_NAVIGATE_RIGHT,
+
+  INPUT_ACTIONS_MAX,
 };
 /// InputAction
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// InputMode
+enum InputMode {
+  INPUT_MODE_LIVE = 0,
+  INPUT_MODE_RECORD,
+  INPUT_MODE_REPLAY,
+};
+/// InputMode
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKReplayHeader
+struct NKReplayHeader {
+  char magic[4]; // Always "NKRP"
+
+  nikola::u8 major_version;
+  nikola::u8 minor_version;
+  nikola::u16 reserved;
+
+  nikola::u32 frames_count;
+  nikola::u32 data_size;
+};
+/// NKReplayHeader
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Input manager functions
 
+void input_manager_update(const float delta_time);
+
 const bool input_manager_action_pressed(const InputAction action);
 
 const nikola::Vec3 input_manager_get_movement_velocity();
 
+const float input_manager_get_delta_time();
+
+const InputMode input_manager_get_mode();
+
+const bool input_manager_record_begin(const nikola::FilePath& path);
+
+void input_manager_record_end();
+
+const bool input_manager_replay_begin(const nikola::FilePath& path);
+
+void input_manager_replay_end();
+
 /// Input manager functions
 /// ----------------------------------------------------------------------
@@ -0,0 +1,103 @@
+#include "level.h"
+
+#include <nikola/nikola.h>
+
+#if NIKOLA_PLATFORM_WINDOWS == 1
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// ----------------------------------------------------------------------
+/// NKFileMapping functions
+
+const bool file_mapping_open(NKFileMapping* mapping, const nikola::FilePath& path) {
+  NIKOLA_ASSERT(mapping, "Invalid mapping given to file_mapping_open");
+  file_mapping_close(mapping);
+
+  /*
+   * @NOTE:
+   *
+   * The files are mapped as copy-on-write. The game never writes through a mapping,
+   * but the editor is allowed to poke at the mapped data in place without the changes
+   * ever reaching the file on disk. Saving always goes through the normal file functions.
+   *
+   */
+
+#if NIKOLA_PLATFORM_WINDOWS == 1
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE handle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file); // The mapping keeps the file alive
+
+  if(!handle) {
+    return false;
+  }
+
+  void* data = MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, 0);
+  if(!data) {
+    CloseHandle(handle);
+    return false;
+  }
+
+  mapping->data   = (nikola::u8*)data;
+  mapping->size   = (nikola::sizei)file_size.QuadPart;
+  mapping->handle = handle;
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if(file == -1) {
+    return false;
+  }
+
+  struct stat file_stat;
+  if(fstat(file, &file_stat) == -1 || file_stat.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  void* data = mmap(nullptr, (size_t)file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+  close(file); // The mapping keeps the file alive
+
+  if(data == MAP_FAILED) {
+    return false;
+  }
+
+  mapping->data   = (nikola::u8*)data;
+  mapping->size   = (nikola::sizei)file_stat.st_size;
+  mapping->handle = nullptr;
+#endif
+
+  return true;
+}
+
+void file_mapping_close(NKFileMapping* mapping) {
+  if(!mapping->data) {
+    return;
+  }
+
+#if NIKOLA_PLATFORM_WINDOWS == 1
+  UnmapViewOfFile(mapping->data);
+  CloseHandle((HANDLE)mapping->handle);
+#else
+  munmap(mapping->data, mapping->size);
+#endif
+
+  mapping->data   = nullptr;
+  mapping->size   = 0;
+  mapping->handle = nullptr;
+}
+
+/// NKFileMapping functions
+/// ----------------------------------------------------------------------
@@ -9,11 +9,14 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_stdlib.h>
 
+#include <utility>
+
 /// ----------------------------------------------------------------------
 /// Consts
 
-const nikola::u8 NKLVL_VERSION_MAJOR = 0; 
-const nikola::u8 NKLVL_VERSION_MINOR = 2; 
+// Anything more than this in a single frame gets dropped instead of 
+// making the next frame even slower to catch up.
+const nikola::sizei LEVEL_STEPS_MAX = 8;
 
 /// Consts
 /// ----------------------------------------------------------------------
@@ -163,6 +166,39 @@ static void init_ui(Level* lvl) {
   lvl->pause_layout.is_active = false;
 }
 
+static void init_level_state(Level* lvl) {
+  // Reset the camera
+  lvl->main_camera.position     = lvl->lerp_points[LERP_POINT_DEFAULT];
+  lvl->previous_camera_position = lvl->main_camera.position;
+
+  // Reset the simulation
+  lvl->step_accumulator = 0.0f;
+  lvl->step_alpha       = 0.0f;
+
+  // Reset the light
+  if(lvl->nkbin.has_coin) {
+    lvl->frame.point_lights[0].position   = lvl->nkbin.coin_position;
+    lvl->frame.point_lights[0].position.y = 2.0f;
+
+    lvl->current_light_color = nikola::Vec3(4.0f, 4.0f, 0.5f);
+  }
+  else {
+    lvl->frame.point_lights[0].position = nikola::Vec3(-2000.0f);
+    lvl->current_light_color            = nikola::Vec3(0.0f);
+  }
+}
+
+static void init_level_content(Level* lvl) {
+  // Camera and lights
+  init_level_state(lvl);
+
+  // Load entities
+  entity_manager_load();
+
+  // Load tiles
+  tile_manager_load();
+}
+
 /// Private functions
 /// ----------------------------------------------------------------------
 
@@ -207,8 +243,8 @@ Level* level_create(nikola::Window* window) {
 
   // Listen to events
   nikola::event_listen(nikola::EVENT_MOUSE_SCROLL_WHEEL, mouse_scroll_event, &lvl->gui_camera);
-  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_changed, lvl);
-  game_event_listen(GAME_EVENT_COIN_COLLECTED, on_key_collected, lvl);
+  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_changed, lvl, &lvl->event_scope);
+  game_event_listen(GAME_EVENT_COIN_COLLECTED, on_key_collected, lvl, &lvl->event_scope);
 
   // Current camera init
   lvl->frame.camera   = lvl->main_camera;
@@ -253,33 +289,104 @@ bool level_load(Level* lvl, const nikola::FilePath& path) {
     return false;
   }
 
-  // Reset the camera
-  lvl->main_camera.position = lvl->lerp_points[LERP_POINT_DEFAULT];
+  // Entities init
+  init_level_content(lvl);
 
-  // Reset the light
-  if(lvl->nkbin.has_coin) {
-    lvl->frame.point_lights[0].position   = lvl->nkbin.coin_position;
-    lvl->frame.point_lights[0].position.y = 2.0f;
+  NIKOLA_PERF_TIMER_END(timer, (nikola::filepath_filename(path)).c_str());
+  return true;
+}
 
-    lvl->current_light_color = nikola::Vec3(4.0f, 4.0f, 0.5f);
-  }
-  else {
-    lvl->frame.point_lights[0].position = nikola::Vec3(-2000.0f);
-    lvl->current_light_color            = nikola::Vec3(0.0f);
-  }
+bool level_load_prefetched(Level* lvl, NKLevelFile* nklvl) {
+  NIKOLA_ASSERT(lvl, "Invalid level given to level_load_prefetched");
+  NIKOLA_ASSERT(nklvl, "Invalid level file given to level_load_prefetched");
+  
+  nikola::PerfTimer timer; 
+  NIKOLA_PERF_TIMER_BEGIN(timer);
 
-  // Load entities
-  entity_manager_load();
+  // The level file was already read and decoded somewhere else. We just take it. 
+  // The level's old (and already unloaded) file goes the other way, 
+  // so both sides keep their memory around for the next time.
+  std::swap(lvl->nkbin, *nklvl);
 
-  // Load tiles
-  tile_manager_load();
+  // Entities init
+  init_level_content(lvl);
 
-  NIKOLA_PERF_TIMER_END(timer, (nikola::filepath_filename(path)).c_str());
+  NIKOLA_PERF_TIMER_END(timer, (nikola::filepath_filename(lvl->nkbin.path)).c_str());
   return true;
 }
 
+void level_transition(Level* lvl, NKLevelFile* nklvl) {
+  NIKOLA_ASSERT(lvl, "Invalid level given to level_transition");
+  NIKOLA_ASSERT(nklvl, "Invalid level file given to level_transition");
+  
+  nikola::PerfTimer timer; 
+  NIKOLA_PERF_TIMER_BEGIN(timer);
+
+  // Take the new level file. The old one goes the other way so the 
+  // caller can unload it once we're done.
+  std::swap(lvl->nkbin, *nklvl);
+
+  // Camera and lights
+  init_level_state(lvl);
+
+  // Only touch what actually changed between the two levels
+  
+  TransitionStats stats = {};
+  entity_manager_transition(&stats);
+  tile_manager_transition(&stats);
+
+  nikola::String label = nikola::filepath_filename(lvl->nkbin.path) + 
+                         " (reused " + std::to_string(stats.reused_bodies) + 
+                         ", rebuilt " + std::to_string(stats.rebuilt_bodies) + " bodies)";
+  NIKOLA_PERF_TIMER_END(timer, label.c_str());
+}
+
+void level_park(Level* lvl, NKLevelFile* resident) {
+  NIKOLA_ASSERT(lvl, "Invalid level given to level_park");
+  NIKOLA_ASSERT(resident, "Invalid level file given to level_park");
+
+  // Entities and tiles stay alive, just out of the way
+  entity_manager_park();
+  tile_manager_park();
+
+  // The decoded level goes with them. The level gets the resident's 
+  // empty file in return, ready for the next load.
+  std::swap(lvl->nkbin, *resident);
+}
+
+void level_unpark(Level* lvl, NKLevelFile* resident) {
+  NIKOLA_ASSERT(lvl, "Invalid level given to level_unpark");
+  NIKOLA_ASSERT(resident, "Invalid level file given to level_unpark");
+  
+  nikola::PerfTimer timer; 
+  NIKOLA_PERF_TIMER_BEGIN(timer);
+
+  // Take the parked level back. The current level must 
+  // be unloaded already, so the resident file gets left empty. 
+  std::swap(lvl->nkbin, *resident);
+
+  // Camera and lights
+  init_level_state(lvl);
+
+  // Wake everything up
+  entity_manager_unpark();
+  tile_manager_unpark();
+
+  NIKOLA_PERF_TIMER_END(timer, (nikola::filepath_filename(lvl->nkbin.path)).c_str());
+}
+
 void level_destroy(Level* lvl) {
   NIKOLA_ASSERT(lvl, "Invalid level given to level_destroy");
+  
+  game_event_scope_clear(&lvl->event_scope);
+
+  // Every unloaded body ends up in the pool
+  body_pool_clear();
+
+  // Along with every entity that was ever made
+  entity_slots_clear();
+
+  level_arena_destroy(&lvl->nkbin.arena);
   delete lvl;
 }
 
@@ -291,11 +398,15 @@ void level_unload(Level* lvl) {
 
   // Tiles destroy
   tile_manager_destroy();
+
+  // Release the level's data
+  nklvl_file_unload(&lvl->nkbin);
 }
 
 void level_reset(Level* lvl) {
   // Reset variables
-  lvl->is_paused = false; 
+  lvl->is_paused        = false; 
+  lvl->step_accumulator = 0.0f;
   
   // Reset layout
   
@@ -343,27 +454,70 @@ void level_process_input(Level* lvl) {
   }
 }
 
-void level_update(Level* lvl) {
-  if(lvl->is_paused) {
-    return;
-  }
-
-  float delta = nikola::niclock_get_delta_time() * 1.5f;
+void level_step(Level* lvl, const float delta_time) {
+  float delta = delta_time * 1.5f;
 
   // Keep lerping the camera which is honestly a bad idea
-  nikola::Camera* camera = &lvl->main_camera;
-  camera->position       = nikola::vec3_lerp(camera->position, lvl->current_lerp_point, delta);
+  nikola::Camera* camera        = &lvl->main_camera;
+  lvl->previous_camera_position = camera->position;
+  camera->position              = nikola::vec3_lerp(camera->position, lvl->current_lerp_point, delta);
 
   // Also not a good idea, but lerp the point light color as well
   nikola::PointLight* light = &lvl->frame.point_lights[0];
   light->color              = nikola::vec3_lerp(light->color, lvl->current_light_color, delta);
 
   // Update entities
-  entity_manager_update();
+  entity_manager_update(delta_time);
+}
+
+void level_update(Level* lvl) {
+  if(lvl->is_paused) {
+    return;
+  }
+
+  // Simulate in fixed steps no matter how long the frame took
+
+  // The frame time goes through the input manager so replays can reproduce it
+  lvl->step_accumulator += input_manager_get_delta_time();
+  
+  nikola::sizei steps = 0;
+  while(lvl->step_accumulator >= LEVEL_FIXED_STEP && steps < LEVEL_STEPS_MAX) {
+    level_step(lvl, LEVEL_FIXED_STEP);
+
+    lvl->step_accumulator -= LEVEL_FIXED_STEP;
+    steps++;
+  }
+
+  // Way too far behind. Just let it go.
+  if(steps == LEVEL_STEPS_MAX) {
+    lvl->step_accumulator = 0.0f;
+  }
+
+  // The physics world only gets stepped once a frame
+  entity_manager_apply_forces();
+
+  lvl->step_alpha = lvl->step_accumulator / LEVEL_FIXED_STEP;
 
   // Camera update
-  lvl->frame.camera = *lvl->current_camera;
-  nikola::camera_update(*lvl->current_camera);
+
+  nikola::Camera* camera = lvl->current_camera;
+  if(camera != &lvl->main_camera) {
+    lvl->frame.camera = *camera;
+    nikola::camera_update(*camera);
+
+    return;
+  }
+
+  // The main camera only moves with the simulation, so render 
+  // it in between the last two steps. 
+  
+  nikola::Vec3 position = camera->position; 
+  camera->position      = nikola::vec3_lerp(lvl->previous_camera_position, position, lvl->step_alpha);
+  
+  nikola::camera_update(*camera);
+  lvl->frame.camera = *camera;
+
+  camera->position = position;
 }
 
 void level_render_hud(Level* lvl) {
@@ -376,6 +530,10 @@ void level_render_hud(Level* lvl) {
 }
 
 void level_render(Level* lvl) {
+  // Only what the camera can see gets queued
+  frustum_create(&lvl->frustum, lvl->frame.camera.view_projection);
+  lvl->culling_stats = CullingStats{};
+
   // Render entities
   entity_manager_render();
 
@@ -435,6 +593,7 @@ void level_render_gui(Level* lvl) {
 
     // Debug mode
     ImGui::Checkbox("Debug Mode", &lvl->debug_mode);
+    ImGui::Text("Visible: %zu, Culled: %zu", lvl->culling_stats.visible, lvl->culling_stats.culled);
    
     // Paused mode
    
@@ -449,6 +608,9 @@ void level_render_gui(Level* lvl) {
     if(ImGui::Button("Save level")) {
       nikola::filepath_set_filename(lvl->nkbin.path, lvl_path); 
 
+      // The prefetch worker might still be reading the very file (or archive entry) that gets rewritten
+      level_manager_prefetch_wait();
+
       entity_manager_save();
       tile_manager_save();
       nklvl_file_save(lvl->nkbin);
@@ -2,25 +2,46 @@
 
 #include "entities\entity.h"
 #include "ui\ui.h"
+#include "game_event.h"
 
 #include <nikola/nikola.h>
 
 /// ----------------------------------------------------------------------
 /// Consts
 
-/// @NOTE: These constants are not the final required sizes. They are 
-/// only here to avoid memory allocation when loading a `nklvl` file. 
-/// Besides that, they help to set light boundries to the amount of 
-/// entities we can have in a level. Again, though, they are not "set in stone", per se. 
-
-const nikola::sizei POINTS_MAX       = 6;
-const nikola::sizei TILES_MAX        = 256;
-const nikola::sizei VEHICLES_MAX     = 12;
 const nikola::sizei LEVEL_GROUPS_MAX = 5;
 
+const float LEVEL_FIXED_STEP = 1.0f / 120.0f;
+
 /// Consts
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// NKFileMapping
+struct NKFileMapping {
+  nikola::u8* data   = nullptr; 
+  nikola::sizei size = 0;
+
+  void* handle = nullptr;
+};
+/// NKFileMapping
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// LevelArena
+struct LevelArena {
+  nikola::u8* data       = nullptr;
+  nikola::sizei capacity = 0; 
+  nikola::sizei offset   = 0;
+
+  // Blocks that ran out of space while still being used. 
+  // They only get freed once the arena is reset.
+  nikola::DynamicArray<nikola::u8*> retired;
+  nikola::sizei total_used = 0;
+};
+/// LevelArena
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// NKLevelFile
 struct NKLevelFile {
@@ -39,43 +60,81 @@ struct NKLevelFile {
   nikola::Vec3 coin_position = nikola::Vec3(-1000.0f); 
   bool has_coin              = false;
 
+  /// @NOTE: All of the sections below are tightly packed arrays that either 
+  /// point directly into the mapped file (v0.3 and above) or into `arena` 
+  /// (older versions and any edits done by the editor). Either way, they are 
+  /// only valid until the next `nklvl_file_load` or `nklvl_file_unload`. 
+  /// There is no upper limit to the amount of entities besides memory.
+
   // End points
   
-  struct NKEntity {
-    nikola::Vec3 position; 
-    nikola::Vec3 scale;
-    nikola::u16 type;
-  };
+  struct NKPoints {
+    nikola::sizei count = 0;
 
-  nikola::sizei points_count = 0;
-  NKEntity points[POINTS_MAX];
+    nikola::Vec3* positions = nullptr; 
+    nikola::Vec3* scales    = nullptr;
+    nikola::u16* types      = nullptr;
+  } points;
 
   // Vehicles
 
-  struct NKVehicle {
-    nikola::Vec3 position;
-    nikola::Vec3 direction; 
-
-    float acceleration;
-    nikola::u8 vehicle_type;
-  };
+  struct NKVehicles {
+    nikola::sizei count = 0;
 
-  nikola::sizei vehicles_count = 0;
-  NKVehicle vehicles[VEHICLES_MAX];
+    nikola::Vec3* positions  = nullptr;
+    nikola::Vec3* directions = nullptr; 
+    float* accelerations     = nullptr;
+    nikola::u8* types        = nullptr;
+  } vehicles;
 
   // Tiles
 
-  struct NKTile {
-    nikola::Vec3 position;
-    nikola::u8 tile_type;
-  };
+  struct NKTiles {
+    nikola::sizei count = 0;
 
-  nikola::sizei tiles_count = 0; 
-  NKTile tiles[TILES_MAX];
+    nikola::Vec3* positions = nullptr;
+    nikola::u8* types       = nullptr;
+  } tiles;
+
+  // Memory
+
+  NKFileMapping mapping;
+  LevelArena arena;
 };
 /// NKLevelFile
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// NKPakHeader
+struct NKPakHeader {
+  char magic[4]; // Always "NKPK"
+
+  nikola::u8 major_version; 
+  nikola::u8 minor_version;
+  nikola::u16 entries_count;
+
+  nikola::u32 toc_offset;
+  nikola::u32 file_size;
+};
+/// NKPakHeader
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKPakEntry
+struct NKPakEntry {
+  char name[16]; // The original file name (`C1L2.nklvl`, for example)
+
+  nikola::u8 group_index; 
+  nikola::u8 level_index;
+  nikola::u16 reserved;
+
+  nikola::u32 offset; 
+  nikola::u32 size;
+  nikola::u32 padding;
+};
+/// NKPakEntry
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// Level
 struct Level {
@@ -89,6 +148,11 @@ struct Level {
   nikola::Camera* current_camera;
   nikola::FrameData frame; 
 
+  // Culling
+  
+  Frustum frustum;
+  CullingStats culling_stats;
+
   // State
 
   nikola::Vec3 lerp_points[4];
@@ -99,6 +163,16 @@ struct Level {
   UILayout pause_layout;
 
   bool is_paused = false;
+
+  // Everything listening on this level goes away with it
+  GameEventScope event_scope;
+
+  // Simulation
+
+  float step_accumulator = 0.0f; 
+  float step_alpha       = 0.0f; // How far rendering is between the last two steps
+
+  nikola::Vec3 previous_camera_position;
   
   // Debug stuff
   
@@ -108,16 +182,71 @@ struct Level {
 /// Level
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// LevelArena functions
+
+void* level_arena_push(LevelArena* arena, const nikola::sizei size);
+
+void level_arena_reset(LevelArena* arena);
+
+void level_arena_destroy(LevelArena* arena);
+
+/// LevelArena functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKFileMapping functions
+
+const bool file_mapping_open(NKFileMapping* mapping, const nikola::FilePath& path);
+
+void file_mapping_close(NKFileMapping* mapping);
+
+/// NKFileMapping functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// NKLevelFile functions
 
 const bool nklvl_file_load(NKLevelFile* nklvl, const nikola::FilePath& path);
 
+const bool nklvl_file_load_memory(NKLevelFile* nklvl, nikola::u8* data, const nikola::sizei size);
+
+void nklvl_file_touch(const NKLevelFile& nklvl);
+
+void nklvl_file_unload(NKLevelFile* nklvl);
+
+void nklvl_file_resize(NKLevelFile* nklvl, 
+                       const nikola::sizei points_count, 
+                       const nikola::sizei vehicles_count, 
+                       const nikola::sizei tiles_count);
+
+const nikola::sizei nklvl_file_get_image_size(const NKLevelFile& nklvl);
+
+void nklvl_file_write(nikola::File& file, const NKLevelFile& nklvl);
+
 void nklvl_file_save(const NKLevelFile& nklvl);
 
 /// NKLevelFile functions
 /// ----------------------------------------------------------------------
 
+/// ----------------------------------------------------------------------
+/// NKPak functions
+
+const bool nkpak_file_open(const nikola::FilePath& path);
+
+void nkpak_file_close();
+
+const nikola::DynamicArray<NKPakEntry>& nkpak_file_get_entries();
+
+const bool nkpak_file_find(const nikola::FilePath& filename, nikola::u8** data, nikola::sizei* size);
+
+void nkpak_file_invalidate(const nikola::FilePath& filename);
+
+const bool nkpak_parse_level_name(const nikola::FilePath& filename, nikola::u8* group_index, nikola::u8* level_index);
+
+/// NKPak functions
+/// ----------------------------------------------------------------------
+
 /// ----------------------------------------------------------------------
 /// NKData functions
 
@@ -143,6 +272,14 @@ Level* level_create(nikola::Window* window);
 
 bool level_load(Level* lvl, const nikola::FilePath& path);
 
+bool level_load_prefetched(Level* lvl, NKLevelFile* nklvl);
+
+void level_transition(Level* lvl, NKLevelFile* nklvl);
+
+void level_park(Level* lvl, NKLevelFile* resident);
+
+void level_unpark(Level* lvl, NKLevelFile* resident);
+
 void level_destroy(Level* lvl);
 
 void level_unload(Level* lvl);
@@ -151,6 +288,8 @@ void level_reset(Level* lvl);
 
 void level_process_input(Level* lvl);
 
+void level_step(Level* lvl, const float delta_time);
+
 void level_update(Level* lvl);
 
 void level_render(Level* lvl);
@@ -187,5 +326,7 @@ void level_manager_get_current_indices(nikola::sizei* group_index, nikola::sizei
 
 Level* level_manager_get_current_level();
 
+void level_manager_prefetch_wait();
+
 /// Level manager functions
 /// ----------------------------------------------------------------------
@@ -0,0 +1,103 @@
+#include "level.h"
+
+#include <nikola/nikola.h>
+
+#include <cstring>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::sizei ARENA_ALIGNMENT    = 16;
+const nikola::sizei ARENA_MIN_CAPACITY = 64 * 1024;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static nikola::sizei align_size(const nikola::sizei size) {
+  return (size + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static void allocate_block(LevelArena* arena, const nikola::sizei capacity) {
+  // `new` hands back memory aligned for any fundamental type, which covers `ARENA_ALIGNMENT`
+  arena->data     = new nikola::u8[capacity];
+  arena->capacity = capacity;
+  arena->offset   = 0;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// LevelArena functions
+
+void* level_arena_push(LevelArena* arena, const nikola::sizei size) {
+  NIKOLA_ASSERT(arena, "Invalid arena given to level_arena_push");
+
+  nikola::sizei aligned_size = align_size(size);
+
+  // Not enough room left. The current block might still be in use, so
+  // we retire it instead of freeing it, and start over with a bigger one.
+  if(aligned_size > (arena->capacity - arena->offset)) {
+    if(arena->data) {
+      arena->retired.push_back(arena->data);
+    }
+
+    nikola::sizei capacity = arena->capacity * 2;
+    if(capacity < ARENA_MIN_CAPACITY) {
+      capacity = ARENA_MIN_CAPACITY;
+    }
+    if(capacity < aligned_size) {
+      capacity = aligned_size;
+    }
+
+    allocate_block(arena, capacity);
+  }
+
+  void* ptr = arena->data + arena->offset;
+  memset(ptr, 0, aligned_size);
+
+  arena->offset     += aligned_size;
+  arena->total_used += aligned_size;
+
+  return ptr;
+}
+
+void level_arena_reset(LevelArena* arena) {
+  NIKOLA_ASSERT(arena, "Invalid arena given to level_arena_reset");
+
+  // The arena had to grow while being used. Merge everything into one
+  // block that fits the biggest level seen so far, so the next
+  // level of that size never has to allocate.
+  if(!arena->retired.empty()) {
+    for(auto& block : arena->retired) {
+      delete[] block;
+    }
+    arena->retired.clear();
+
+    nikola::sizei capacity = arena->total_used;
+    delete[] arena->data;
+
+    allocate_block(arena, capacity);
+  }
+
+  arena->offset     = 0;
+  arena->total_used = 0;
+}
+
+void level_arena_destroy(LevelArena* arena) {
+  NIKOLA_ASSERT(arena, "Invalid arena given to level_arena_destroy");
+
+  for(auto& block : arena->retired) {
+    delete[] block;
+  }
+  arena->retired.clear();
+
+  delete[] arena->data;
+  *arena = LevelArena{};
+}
+
+/// LevelArena functions
+/// ----------------------------------------------------------------------
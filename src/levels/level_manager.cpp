@@ -9,6 +9,8 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_stdlib.h>
 
+#include <thread>
+
 /// ----------------------------------------------------------------------
 /// Consts
 
@@ -43,6 +45,21 @@ struct LevelManager {
   
   UIText texts[GROUP_TEXTS_MAX];
   bool can_show_hud = false;
+
+  // Prefetching
+  
+  NKLevelFile prefetch_file;
+  nikola::FilePath prefetch_path;
+  
+  std::thread prefetch_thread;
+  bool has_prefetched = false;
+
+  // The hub gets visited between every group, so it never leaves memory
+  
+  NKLevelFile hub_file;
+  bool is_hub_parked = false;
+
+  GameEventScope event_scope;
 };
 
 static LevelManager s_manager{};
@@ -102,21 +119,116 @@ static void init_group_ui(nikola::Window* window, const nikola::ResourceID& font
   ui_text_create(&s_manager.texts[3], window, text_desc);
 }
 
-static nikola::sizei get_index_from_pos(Entity* point) {
-  int pos_x = (int)nikola::physics_body_get_position(point->body).x;
-  
-  switch(pos_x) {
-    case 0:
-      return 1;
-    case 16:
-      return 2;
-    case 40:
-      return 3;
-    case 64:
-      return 4;
+static void prefetch_wait() {
+  if(s_manager.prefetch_thread.joinable()) {
+    s_manager.prefetch_thread.join();
   }
 }
 
+static void prefetch_level(const nikola::FilePath& path) {
+  // Only one prefetch can be in flight at a time
+  prefetch_wait();
+
+  s_manager.prefetch_path  = path;
+  s_manager.has_prefetched = false;
+
+  // @NOTE: The worker only ever touches `prefetch_file` and `has_prefetched`. 
+  // The main thread stays away from both until the thread is joined.
+  s_manager.prefetch_thread = std::thread([]() {
+    s_manager.has_prefetched = nklvl_file_load(&s_manager.prefetch_file, s_manager.prefetch_path);
+    
+    if(s_manager.has_prefetched) {
+      nklvl_file_touch(s_manager.prefetch_file);
+    }
+
+    // Let the main thread know it can take it from here
+    game_event_post(GameEvent{.type = GAME_EVENT_LEVEL_PREFETCHED});
+  });
+}
+
+static const bool is_hub_path(const nikola::FilePath& path) {
+  return path == s_manager.groups[0].level_paths[0];
+}
+
+static const nikola::FilePath& get_next_level_path() {
+  LevelGroup* level_group = &s_manager.groups[s_manager.current_group];
+ 
+  // Either the next level in the group or back to the hub
+  nikola::sizei next_level = level_group->current_level + 1;
+  if(next_level < level_group->level_paths.size()) {
+    return level_group->level_paths[next_level];
+  }
+
+  return s_manager.groups[0].level_paths[0];
+}
+
+static void unload_level() {
+  // Park the hub instead of throwing it away. Everything else gets unloaded like usual.
+  if(!s_manager.is_hub_parked && is_hub_path(s_manager.current_level->nkbin.path)) {
+    level_park(s_manager.current_level, &s_manager.hub_file);
+    s_manager.is_hub_parked = true;
+
+    return;
+  }
+
+  level_unload(s_manager.current_level);
+}
+
+static const bool load_level(const nikola::FilePath& path) {
+  // The hub is still around. No need to even look at the disk.
+  if(s_manager.is_hub_parked && is_hub_path(path)) {
+    level_unpark(s_manager.current_level, &s_manager.hub_file);
+    s_manager.is_hub_parked = false;
+
+    return true;
+  }
+
+  // Take the prefetched level if it's the one we want. 
+  // Otherwise, go to the disk like usual.
+
+  prefetch_wait();
+
+  bool can_swap            = s_manager.has_prefetched && (s_manager.prefetch_path == path);
+  s_manager.has_prefetched = false;
+
+  if(can_swap) {
+    level_load_prefetched(s_manager.current_level, &s_manager.prefetch_file);
+    nklvl_file_unload(&s_manager.prefetch_file);
+
+    return true;
+  }
+
+  return level_load(s_manager.current_level, path);
+}
+
+static const bool transition_level(const nikola::FilePath& path) {
+  // The hub has nothing in common with the other levels and it's never 
+  // actually unloaded anyway. Go through the usual path for it.
+  if(is_hub_path(path) || is_hub_path(s_manager.current_level->nkbin.path)) {
+    unload_level();
+    return load_level(path);
+  }
+
+  // Use the prefetched level if it's the right one. Otherwise, 
+  // the prefetch file is free to be loaded into directly.
+
+  prefetch_wait();
+
+  bool has_file            = s_manager.has_prefetched && (s_manager.prefetch_path == path);
+  s_manager.has_prefetched = false;
+
+  if(!has_file && !nklvl_file_load(&s_manager.prefetch_file, path)) {
+    return false;
+  }
+
+  // Diff the current level against the new one. The old level file ends up 
+  // in the prefetch slot, so we can let go of it here.
+  level_transition(s_manager.current_level, &s_manager.prefetch_file);
+  nklvl_file_unload(&s_manager.prefetch_file);
+
+  return true;
+}
+
 /// Private functions
 /// ----------------------------------------------------------------------
 
@@ -129,8 +241,7 @@ static void on_chapter_changed(const GameEvent& event, void* dispatcher, void* l
     return;
   }
 
-  Entity* point_entt       = (Entity*)dispatcher;
-  s_manager.selected_group = &s_manager.groups[get_index_from_pos(point_entt)];
+  s_manager.selected_group = &s_manager.groups[event.group_index];
   LevelGroup* group        = s_manager.selected_group;
 
   // Set up the UI
@@ -163,7 +274,26 @@ static void on_coin_collected(const GameEvent& event, void* dispatcher, void* li
   group->coins_collected++;
 }
 
+static void on_level_prefetched(const GameEvent& event, void* dispatcher, void* listener) {
+  // The worker is on its way out by now, so this barely blocks
+  prefetch_wait();
+
+  if(s_manager.has_prefetched) {
+    NIKOLA_LOG_TRACE("Prefetched \'%s\'", s_manager.prefetch_path.c_str());
+  }
+}
+
 static void on_state_changed(const GameEvent& event, void* dispatcher, void* listener) {
+  // Start reading the next level while the player is busy with the won screen
+  if(event.state_type == STATE_WON) {
+    const nikola::FilePath& next_path = get_next_level_path();
+    if(!(s_manager.is_hub_parked && is_hub_path(next_path))) {
+      prefetch_level(next_path);
+    }
+
+    return;
+  }
+
   if(event.state_type != STATE_LEVEL) {
     return;
   }
@@ -183,18 +313,10 @@ static void on_state_changed(const GameEvent& event, void* dispatcher, void* lis
 }
 
 static void level_directory_iterate_func(const nikola::FilePath& base_dir, const nikola::FilePath& current_dir, void* user_data) {
-  /* 
-   * @NOTE (17/6/2025, Mohamed): 
-   *
-   * Since all levels have the `C#L#` convention, where `C` stands for "Chapter" and `L` stands 
-   * for "Level", we can be sure that the 2 letter or character of the filename is always the number 
-   * of the chapter/level group. We can extract that character to determine which group to add this level file to.
-   *
-  */
-  char group_num = nikola::filepath_filename(current_dir)[1];
-  
-  // Getting the exact integer representation of the character
-  int group_index = group_num - '0';
+  nikola::u8 group_index, level_index;
+  if(!nkpak_parse_level_name(nikola::filepath_filename(current_dir), &group_index, &level_index)) {
+    return;
+  }
 
   // Adding the level file to the group
   s_manager.groups[group_index].level_paths.push_back(current_dir);
@@ -211,8 +333,24 @@ void level_manager_init(nikola::Window* window, const nikola::ResourceID& font_i
   s_manager.current_level = level_create(window);
 
   // Level groups init
+  
   nikola::FilePath level_dir = nikola::filepath_append(nikola::filesystem_current_path(), "levels");
-  nikola::filesystem_directory_iterate(level_dir, level_directory_iterate_func);
+  nikola::FilePath pak_path  = nikola::filepath_append(nikola::filesystem_current_path(), "levels.nkpak");
+  
+  if(nkpak_file_open(pak_path)) {
+    // The archive's table of contents is already sorted by group and level
+    for(auto& entry : nkpak_file_get_entries()) {
+      if(entry.group_index >= LEVEL_GROUPS_MAX) {
+        continue;
+      }
+
+      s_manager.groups[entry.group_index].level_paths.push_back(nikola::filepath_append(level_dir, entry.name));
+    }
+  }
+  else {
+    // No archive? Just use the loose level files.
+    nikola::filesystem_directory_iterate(level_dir, level_directory_iterate_func);
+  }
   
   // Load the hub level's content
   level_load(s_manager.current_level, s_manager.groups[0].level_paths[0]);
@@ -221,17 +359,35 @@ void level_manager_init(nikola::Window* window, const nikola::ResourceID& font_i
   init_group_ui(window, font_id);
 
   // Listen to events
-  game_event_listen(GAME_EVENT_CHAPTER_ENTERED, on_chapter_changed);
-  game_event_listen(GAME_EVENT_CHAPTER_EXITED, on_chapter_changed);
-  game_event_listen(GAME_EVENT_COIN_COLLECTED, on_coin_collected);
-  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_changed);
+  game_event_listen(GAME_EVENT_CHAPTER_ENTERED, on_chapter_changed, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_CHAPTER_EXITED, on_chapter_changed, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_COIN_COLLECTED, on_coin_collected, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_changed, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_LEVEL_PREFETCHED, on_level_prefetched, nullptr, &s_manager.event_scope);
 }
 
 void level_manager_shutdown() {
+  game_event_scope_clear(&s_manager.event_scope);
   sound_manager_shutdown();
+
+  prefetch_wait();
+  nklvl_file_unload(&s_manager.prefetch_file);
+  level_arena_destroy(&s_manager.prefetch_file.arena);
   
   level_unload(s_manager.current_level);
+
+  // Bring the hub back just so it can be unloaded properly
+  if(s_manager.is_hub_parked) {
+    level_unpark(s_manager.current_level, &s_manager.hub_file);
+    level_unload(s_manager.current_level);
+
+    s_manager.is_hub_parked = false;
+  }
+  level_arena_destroy(&s_manager.hub_file.arena);
+
   level_destroy(s_manager.current_level);
+
+  nkpak_file_close();
 }
 
 void level_manager_reset() {
@@ -259,20 +415,19 @@ void level_manager_reset() {
   }
 
   // Load the hub level
-  level_unload(s_manager.current_level);
-  level_load(s_manager.current_level, s_manager.groups[0].level_paths[0]);
+  unload_level();
+  load_level(s_manager.groups[0].level_paths[0]);
 }
 
 void level_manager_advance() {
   LevelGroup* level_group = &s_manager.groups[s_manager.current_group];
-  level_unload(s_manager.current_level);
   
   // We'll transition to the hub level if the group is out of levels.
   // Otherwise, we can just continue to the next level in the group.
   
   level_group->current_level++; 
   if(level_group->current_level < level_group->level_paths.size()) {
-    level_load(s_manager.current_level, level_group->level_paths[level_group->current_level]);
+    transition_level(level_group->level_paths[level_group->current_level]);
     game_event_dispatch(GameEvent {
       .type       = GAME_EVENT_STATE_CHANGED, 
       .state_type = STATE_LEVEL 
@@ -285,7 +440,7 @@ void level_manager_advance() {
   // We're out of groups...
   s_manager.current_group++; 
   if(s_manager.current_group >= LEVEL_GROUPS_MAX) {
-    level_load(s_manager.current_level, s_manager.groups[0].level_paths[0]);
+    transition_level(s_manager.groups[0].level_paths[0]);
     game_event_dispatch(GameEvent{
       .type       = GAME_EVENT_STATE_CHANGED, 
       .state_type = STATE_CREDITS
@@ -305,7 +460,7 @@ void level_manager_advance() {
   nkdata_file_set_level_data(s_manager.current_group, level_group->coins_collected);
  
   // To the hub world!
-  level_load(s_manager.current_level, s_manager.groups[0].level_paths[0]);
+  transition_level(s_manager.groups[0].level_paths[0]);
   game_event_dispatch(GameEvent{
     .type       = GAME_EVENT_STATE_CHANGED, 
     .state_type = STATE_LEVEL
@@ -338,8 +493,8 @@ void level_manager_process_input() {
     s_manager.current_group = group->index;
 
     // Loading the new level
-    level_unload(s_manager.current_level);
-    level_load(s_manager.current_level, group->level_paths[group->current_level]);
+    unload_level();
+    load_level(group->level_paths[group->current_level]);
      
     game_event_dispatch(GameEvent{
       .type       = GAME_EVENT_STATE_CHANGED, 
@@ -389,8 +544,8 @@ void level_manager_render_gui() {
 
     for(auto& path : s_manager.groups[i].level_paths) {
       if(ImGui::Selectable(nikola::filepath_filename(path).c_str())) {
-        level_unload(s_manager.current_level);
-        if(!level_load(s_manager.current_level, path)) {
+        unload_level();
+        if(!load_level(path)) {
           continue;
         }
         
@@ -413,5 +568,9 @@ Level* level_manager_get_current_level() {
   return s_manager.current_level;
 }
 
+void level_manager_prefetch_wait() {
+  prefetch_wait();
+}
+
 /// Level manager functions
 /// ----------------------------------------------------------------------
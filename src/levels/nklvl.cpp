@@ -2,134 +2,581 @@
 
 #include <nikola/nikola.h>
 
+#include <cstring>
+
 /// ----------------------------------------------------------------------
 /// Consts
 
-const nikola::u8 NKLVL_VERSION_MAJOR = 0; 
-const nikola::u8 NKLVL_VERSION_MINOR = 2; 
+const nikola::u8 NKLVL_VERSION_MAJOR = 0;
+const nikola::u8 NKLVL_VERSION_MINOR = 3;
+
+// The last version that was still written as interleaved, per-entity fields
+const nikola::u8 NKLVL_LEGACY_VERSION_MINOR = 2;
+
+const nikola::sizei NKLVL_SECTION_ALIGNMENT = 16;
 
 /// Consts
 /// ----------------------------------------------------------------------
 
 /// ----------------------------------------------------------------------
-/// NKLevelFile functions
+/// NKLevelSectionType
+enum NKLevelSectionType {
+  NKLVL_SECTION_POINT_POSITIONS = 0,
+  NKLVL_SECTION_POINT_SCALES,
+  NKLVL_SECTION_POINT_TYPES,
 
-const bool nklvl_file_load(NKLevelFile* nklvl, const nikola::FilePath& path) {
-  // Path init (to save the file if needed later)
-  nklvl->path = path;
+  NKLVL_SECTION_VEHICLE_POSITIONS,
+  NKLVL_SECTION_VEHICLE_DIRECTIONS,
+  NKLVL_SECTION_VEHICLE_ACCELERATIONS,
+  NKLVL_SECTION_VEHICLE_TYPES,
 
-  // Open the file first
-  nikola::File file; 
-  if(!nikola::file_open(&file, nklvl->path, (int)(nikola::FILE_OPEN_READ | nikola::FILE_OPEN_BINARY))) {
-    NIKOLA_LOG_ERROR("Failed to read the level file at \'%s\'", nklvl->path.c_str());
+  NKLVL_SECTION_TILE_POSITIONS,
+  NKLVL_SECTION_TILE_TYPES,
+
+  NKLVL_SECTIONS_MAX = NKLVL_SECTION_TILE_TYPES + 1,
+};
+/// NKLevelSectionType
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKLevelHeader
+struct NKLevelHeader {
+  nikola::u8 major_version;
+  nikola::u8 minor_version;
+  nikola::u8 has_coin;
+  nikola::u8 sections_count;
+
+  nikola::Vec3 start_position;
+  nikola::Vec3 coin_position;
+
+  nikola::u32 file_size;
+};
+static_assert(sizeof(NKLevelHeader) == 32, "NKLevelHeader must stay 32 bytes on disk");
+/// NKLevelHeader
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKLevelSection
+struct NKLevelSection {
+  nikola::u32 type;
+  nikola::u32 offset;
+  nikola::u32 count;
+  nikola::u32 stride;
+};
+static_assert(sizeof(NKLevelSection) == 16, "NKLevelSection must stay 16 bytes on disk");
+/// NKLevelSection
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKLevelReader
+struct NKLevelReader {
+  const nikola::u8* data = nullptr;
+  nikola::sizei size     = 0;
+  nikola::sizei offset   = 0;
+};
+/// NKLevelReader
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private variables
+
+const nikola::u32 SECTION_STRIDES[NKLVL_SECTIONS_MAX] = {
+  sizeof(nikola::Vec3), // Point positions
+  sizeof(nikola::Vec3), // Point scales
+  sizeof(nikola::u16),  // Point types
+
+  sizeof(nikola::Vec3), // Vehicle positions
+  sizeof(nikola::Vec3), // Vehicle directions
+  sizeof(float),        // Vehicle accelerations
+  sizeof(nikola::u8),   // Vehicle types
+
+  sizeof(nikola::Vec3), // Tile positions
+  sizeof(nikola::u8),   // Tile types
+};
+
+const nikola::sizei NKLVL_DATA_OFFSET = sizeof(NKLevelHeader) + (sizeof(NKLevelSection) * NKLVL_SECTIONS_MAX);
+static_assert((NKLVL_DATA_OFFSET % NKLVL_SECTION_ALIGNMENT) == 0, "The section table must end on an aligned boundry");
+
+/// Private variables
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static nikola::sizei align_offset(const nikola::sizei offset) {
+  return (offset + (NKLVL_SECTION_ALIGNMENT - 1)) & ~(NKLVL_SECTION_ALIGNMENT - 1);
+}
+
+static nikola::sizei min_count(const nikola::sizei a, const nikola::sizei b) {
+  return (a < b) ? a : b;
+}
+
+static const bool reader_read(NKLevelReader& reader, void* out, const nikola::sizei size) {
+  if(size > (reader.size - reader.offset)) {
     return false;
   }
 
-  // Read the versions
-  nikola::u8 major_version, minor_version; 
-  nikola::file_read_bytes(file, &nklvl->major_version, sizeof(nklvl->major_version));
-  nikola::file_read_bytes(file, &nklvl->minor_version, sizeof(nklvl->minor_version));
+  memcpy(out, reader.data + reader.offset, size);
+  reader.offset += size;
+
+  return true;
+}
+
+static const bool reader_skip(NKLevelReader& reader, const nikola::sizei size) {
+  if(size > (reader.size - reader.offset)) {
+    return false;
+  }
+
+  reader.offset += size;
+  return true;
+}
+
+static const bool reader_read_count(NKLevelReader& reader, nikola::sizei* count, const nikola::sizei record_size) {
+  if(!reader_read(reader, count, sizeof(nikola::sizei))) {
+    return false;
+  }
+
+  // Make sure the file actually has that many records left
+  return *count <= ((reader.size - reader.offset) / record_size);
+}
+
+static nikola::sizei layout_sections(NKLevelSection* sections,
+                                     const nikola::sizei points_count,
+                                     const nikola::sizei vehicles_count,
+                                     const nikola::sizei tiles_count) {
+  nikola::sizei offset = NKLVL_DATA_OFFSET;
+
+  for(nikola::u32 i = 0; i < NKLVL_SECTIONS_MAX; i++) {
+    nikola::sizei count = tiles_count;
+    if(i <= NKLVL_SECTION_POINT_TYPES) {
+      count = points_count;
+    }
+    else if(i <= NKLVL_SECTION_VEHICLE_TYPES) {
+      count = vehicles_count;
+    }
+
+    sections[i] = NKLevelSection {
+      .type   = i,
+      .offset = (nikola::u32)offset,
+      .count  = (nikola::u32)count,
+      .stride = SECTION_STRIDES[i],
+    };
+
+    offset = align_offset(offset + (count * SECTION_STRIDES[i]));
+  }
+
+  // The total size of the image
+  return offset;
+}
+
+static void write_header(nikola::u8* dest, const NKLevelFile& nklvl, const NKLevelSection* sections, const nikola::sizei size) {
+  NKLevelHeader header = {
+    .major_version  = NKLVL_VERSION_MAJOR,
+    .minor_version  = NKLVL_VERSION_MINOR,
+    .has_coin       = (nikola::u8)nklvl.has_coin,
+    .sections_count = (nikola::u8)NKLVL_SECTIONS_MAX,
+
+    .start_position = nklvl.start_position,
+    .coin_position  = nklvl.coin_position,
+
+    .file_size = (nikola::u32)size,
+  };
+
+  memcpy(dest, &header, sizeof(NKLevelHeader));
+  memcpy(dest + sizeof(NKLevelHeader), sections, sizeof(NKLevelSection) * NKLVL_SECTIONS_MAX);
+}
+
+static void bind_sections(NKLevelFile* nklvl, nikola::u8* base, const NKLevelSection* sections) {
+  // Points
+
+  nklvl->points.count     = sections[NKLVL_SECTION_POINT_POSITIONS].count;
+  nklvl->points.positions = (nikola::Vec3*)(base + sections[NKLVL_SECTION_POINT_POSITIONS].offset);
+  nklvl->points.scales    = (nikola::Vec3*)(base + sections[NKLVL_SECTION_POINT_SCALES].offset);
+  nklvl->points.types     = (nikola::u16*)(base + sections[NKLVL_SECTION_POINT_TYPES].offset);
+
+  // Vehicles
+
+  nklvl->vehicles.count         = sections[NKLVL_SECTION_VEHICLE_POSITIONS].count;
+  nklvl->vehicles.positions     = (nikola::Vec3*)(base + sections[NKLVL_SECTION_VEHICLE_POSITIONS].offset);
+  nklvl->vehicles.directions    = (nikola::Vec3*)(base + sections[NKLVL_SECTION_VEHICLE_DIRECTIONS].offset);
+  nklvl->vehicles.accelerations = (float*)(base + sections[NKLVL_SECTION_VEHICLE_ACCELERATIONS].offset);
+  nklvl->vehicles.types         = (nikola::u8*)(base + sections[NKLVL_SECTION_VEHICLE_TYPES].offset);
+
+  // Tiles
+
+  nklvl->tiles.count     = sections[NKLVL_SECTION_TILE_POSITIONS].count;
+  nklvl->tiles.positions = (nikola::Vec3*)(base + sections[NKLVL_SECTION_TILE_POSITIONS].offset);
+  nklvl->tiles.types     = (nikola::u8*)(base + sections[NKLVL_SECTION_TILE_TYPES].offset);
+}
+
+static const bool validate_sections(const NKLevelSection* sections, const nikola::sizei size) {
+  for(nikola::u32 i = 0; i < NKLVL_SECTIONS_MAX; i++) {
+    const NKLevelSection* section = &sections[i];
+
+    // Sections are always written in order with a known stride
+    if(section->type != i || section->stride != SECTION_STRIDES[i]) {
+      return false;
+    }
+
+    // Every section must be aligned and fully inside the file
+    if((section->offset % NKLVL_SECTION_ALIGNMENT) != 0 || section->offset > size) {
+      return false;
+    }
+
+    if(((nikola::sizei)section->count * section->stride) > (size - section->offset)) {
+      return false;
+    }
+  }
+
+  // All the sections of the same entity should agree on the count
+
+  const NKLevelSection* points   = &sections[NKLVL_SECTION_POINT_POSITIONS];
+  const NKLevelSection* vehicles = &sections[NKLVL_SECTION_VEHICLE_POSITIONS];
+  const NKLevelSection* tiles    = &sections[NKLVL_SECTION_TILE_POSITIONS];
+
+  for(nikola::u32 i = NKLVL_SECTION_POINT_SCALES; i <= NKLVL_SECTION_POINT_TYPES; i++) {
+    if(sections[i].count != points->count) {
+      return false;
+    }
+  }
+
+  for(nikola::u32 i = NKLVL_SECTION_VEHICLE_DIRECTIONS; i <= NKLVL_SECTION_VEHICLE_TYPES; i++) {
+    if(sections[i].count != vehicles->count) {
+      return false;
+    }
+  }
+
+  return sections[NKLVL_SECTION_TILE_TYPES].count == tiles->count;
+}
+
+static const bool bind_image(NKLevelFile* nklvl, nikola::u8* data, const nikola::sizei size) {
+  if(size < NKLVL_DATA_OFFSET) {
+    return false;
+  }
+
+  NKLevelHeader header;
+  memcpy(&header, data, sizeof(NKLevelHeader));
+
+  if(header.sections_count != NKLVL_SECTIONS_MAX || header.file_size > size) {
+    return false;
+  }
+
+  const NKLevelSection* sections = (const NKLevelSection*)(data + sizeof(NKLevelHeader));
+  if(!validate_sections(sections, header.file_size)) {
+    return false;
+  }
+
+  nklvl->start_position = header.start_position;
+  nklvl->coin_position  = header.coin_position;
+  nklvl->has_coin       = header.has_coin;
+
+  // No copies here. The entities read straight from the mapped file.
+  bind_sections(nklvl, data, sections);
+  return true;
+}
 
-  // Checking for the file's validity
-  bool is_valid = (nklvl->major_version == NKLVL_VERSION_MAJOR) && (nklvl->minor_version == NKLVL_VERSION_MINOR);
-  NIKOLA_ASSERT(is_valid, "Found invalid level binary version in given path");
+static const bool decode_legacy_level(NKLevelReader& reader, NKLevelFile* nklvl) {
+  // Skip the versions since they were already checked
+  reader.offset = sizeof(nikola::u8) * 2;
 
-  // Read the starting position 
-  nikola::file_read_bytes(file, &nklvl->start_position[0], sizeof(nklvl->start_position));
+  // Read the starting position
+  if(!reader_read(reader, &nklvl->start_position[0], sizeof(nklvl->start_position))) {
+    return false;
+  }
 
   // Read the coin
-  
-  nikola::file_read_bytes(file, &nklvl->coin_position[0], sizeof(nklvl->coin_position));
-  nikola::file_read_bytes(file, &nklvl->has_coin, sizeof(nklvl->has_coin));
+
+  if(!reader_read(reader, &nklvl->coin_position[0], sizeof(nklvl->coin_position)) ||
+     !reader_read(reader, &nklvl->has_coin, sizeof(nklvl->has_coin))) {
+    return false;
+  }
+
+  // The older versions interleave everything, so we have to
+  // walk the file once to know how big each section is going to be.
+
+  nikola::sizei entities_start = reader.offset;
+  nikola::sizei points_count, vehicles_count, tiles_count;
+
+  const nikola::sizei point_size   = sizeof(nikola::Vec3) + sizeof(nikola::Vec3) + sizeof(nikola::u16);
+  const nikola::sizei vehicle_size = sizeof(nikola::Vec3) + sizeof(nikola::Vec3) + sizeof(float) + sizeof(nikola::u8);
+  const nikola::sizei tile_size    = sizeof(nikola::Vec3) + sizeof(nikola::u8);
+
+  if(!reader_read_count(reader, &points_count, point_size)     || !reader_skip(reader, points_count * point_size)     ||
+     !reader_read_count(reader, &vehicles_count, vehicle_size) || !reader_skip(reader, vehicles_count * vehicle_size) ||
+     !reader_read_count(reader, &tiles_count, tile_size)       || !reader_skip(reader, tiles_count * tile_size)) {
+    return false;
+  }
+
+  // Lay out the sections in memory exactly like a v0.3 file
+
+  NKLevelSection sections[NKLVL_SECTIONS_MAX];
+  nikola::sizei image_size = layout_sections(sections, points_count, vehicles_count, tiles_count);
+
+  nikola::u8* image = (nikola::u8*)level_arena_push(&nklvl->arena, image_size);
+  write_header(image, *nklvl, sections, image_size);
+  bind_sections(nklvl, image, sections);
+
+  // Now we can actually decode the entities
+
+  reader.offset = entities_start;
 
   // Read the end points
-  
-  nikola::file_read_bytes(file, &nklvl->points_count, sizeof(nklvl->points_count));
-  for(nikola::sizei i = 0; i < nklvl->points_count; i++) {
-    nikola::file_read_bytes(file, &nklvl->points[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_read_bytes(file, &nklvl->points[i].scale[0], sizeof(nikola::Vec3));
-    nikola::file_read_bytes(file, &nklvl->points[i].type, sizeof(nikola::u16));
+
+  reader_skip(reader, sizeof(nikola::sizei));
+  for(nikola::sizei i = 0; i < nklvl->points.count; i++) {
+    reader_read(reader, &nklvl->points.positions[i][0], sizeof(nikola::Vec3));
+    reader_read(reader, &nklvl->points.scales[i][0], sizeof(nikola::Vec3));
+    reader_read(reader, &nklvl->points.types[i], sizeof(nikola::u16));
   }
 
   // Read the vehicles
 
-  nikola::file_read_bytes(file, &nklvl->vehicles_count, sizeof(nklvl->vehicles_count));
-  for(nikola::sizei i = 0; i < nklvl->vehicles_count; i++) {
-    nikola::file_read_bytes(file, &nklvl->vehicles[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_read_bytes(file, &nklvl->vehicles[i].direction[0], sizeof(nikola::Vec3));
-    nikola::file_read_bytes(file, &nklvl->vehicles[i].acceleration, sizeof(float));
-    nikola::file_read_bytes(file, &nklvl->vehicles[i].vehicle_type, sizeof(nikola::u8));
+  reader_skip(reader, sizeof(nikola::sizei));
+  for(nikola::sizei i = 0; i < nklvl->vehicles.count; i++) {
+    reader_read(reader, &nklvl->vehicles.positions[i][0], sizeof(nikola::Vec3));
+    reader_read(reader, &nklvl->vehicles.directions[i][0], sizeof(nikola::Vec3));
+    reader_read(reader, &nklvl->vehicles.accelerations[i], sizeof(float));
+    reader_read(reader, &nklvl->vehicles.types[i], sizeof(nikola::u8));
   }
 
   // Read the tiles
-  
-  nikola::file_read_bytes(file, &nklvl->tiles_count, sizeof(nklvl->tiles_count));
-  for(nikola::sizei i = 0; i < nklvl->tiles_count; i++) {
-    nikola::file_read_bytes(file, &nklvl->tiles[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_read_bytes(file, &nklvl->tiles[i].tile_type, sizeof(nikola::u8));
+
+  reader_skip(reader, sizeof(nikola::sizei));
+  for(nikola::sizei i = 0; i < nklvl->tiles.count; i++) {
+    reader_read(reader, &nklvl->tiles.positions[i][0], sizeof(nikola::Vec3));
+    reader_read(reader, &nklvl->tiles.types[i], sizeof(nikola::u8));
   }
 
-  // Always remember to close the file
-  nikola::file_close(file);
   return true;
 }
 
-void nklvl_file_save(const NKLevelFile& nklvl) {
-  // Open the file first
-  nikola::File file; 
-  if(!nikola::file_open(&file, nklvl.path, (int)(nikola::FILE_OPEN_WRITE | nikola::FILE_OPEN_BINARY))) {
-    NIKOLA_LOG_ERROR("Failed to save the level file at \'%s\'", nklvl.path.c_str());
-    return;
+static void reset_sections(NKLevelFile* nklvl) {
+  nklvl->points   = {};
+  nklvl->vehicles = {};
+  nklvl->tiles    = {};
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKLevelFile functions
+
+const bool nklvl_file_load(NKLevelFile* nklvl, const nikola::FilePath& path) {
+  nklvl_file_unload(nklvl);
+
+  // Path init (to save the file if needed later)
+  nklvl->path = path;
+
+  // The level might already be sitting in the level archive. 
+  // Otherwise, map the loose file into memory.
+
+  nikola::u8* data   = nullptr;
+  nikola::sizei size = 0;
+
+  if(!nkpak_file_find(nikola::filepath_filename(path), &data, &size)) {
+    if(!file_mapping_open(&nklvl->mapping, nklvl->path)) {
+      NIKOLA_LOG_ERROR("Failed to read the level file at \'%s\'", nklvl->path.c_str());
+      return false;
+    }
+
+    data = nklvl->mapping.data;
+    size = nklvl->mapping.size;
   }
 
-  // Wrtie the versions
-  nikola::file_write_bytes(file, &nklvl.major_version, sizeof(nklvl.major_version));
-  nikola::file_write_bytes(file, &nklvl.minor_version, sizeof(nklvl.minor_version));
+  if(!nklvl_file_load_memory(nklvl, data, size)) {
+    NIKOLA_LOG_ERROR("Level file at \'%s\' is corrupted", nklvl->path.c_str());
+    nklvl_file_unload(nklvl);
 
-  // Wrtie the starting position 
-  nikola::file_write_bytes(file, &nklvl.start_position[0], sizeof(nklvl.start_position));
-  
-  // Write the coin
-  
-  nikola::file_write_bytes(file, &nklvl.coin_position[0], sizeof(nklvl.coin_position));
-  nikola::file_write_bytes(file, &nklvl.has_coin, sizeof(nklvl.has_coin));
+    return false;
+  }
 
-  // Wrtie the end points
-  
-  nikola::file_write_bytes(file, &nklvl.points_count, sizeof(nklvl.points_count));
+  return true;
+}
 
-  for(nikola::sizei i = 0; i < nklvl.points_count; i++) {
-    nikola::file_write_bytes(file, &nklvl.points[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_write_bytes(file, &nklvl.points[i].scale[0], sizeof(nikola::Vec3));
-    nikola::file_write_bytes(file, &nklvl.points[i].type, sizeof(nikola::u16));
+const bool nklvl_file_load_memory(NKLevelFile* nklvl, nikola::u8* data, const nikola::sizei size) {
+  if(size < (sizeof(nikola::u8) * 2)) {
+    return false;
   }
 
-  // Wrtie the vehicles
+  // Read the versions
+  nklvl->major_version = data[0];
+  nklvl->minor_version = data[1];
 
-  nikola::file_write_bytes(file, &nklvl.vehicles_count, sizeof(nklvl.vehicles_count));
+  if(nklvl->major_version == NKLVL_VERSION_MAJOR && nklvl->minor_version == NKLVL_VERSION_MINOR) {
+    return bind_image(nklvl, data, size);
+  }
+  else if(nklvl->major_version == NKLVL_VERSION_MAJOR && nklvl->minor_version == NKLVL_LEGACY_VERSION_MINOR) {
+    NKLevelReader reader = {
+      .data = data,
+      .size = size,
+    };
+    bool is_valid = decode_legacy_level(reader, nklvl);
 
-  for(nikola::sizei i = 0; i < nklvl.vehicles_count; i++) {
-    nikola::Vec3 position   = nklvl.vehicles[i].position;
-    nikola::u8 vehicle_type = (nikola::u8)nklvl.vehicles[i].vehicle_type;
+    // Everything lives in the arena now. The file is no longer needed.
+    file_mapping_close(&nklvl->mapping);
+    return is_valid;
+  }
 
-    nikola::file_write_bytes(file, &nklvl.vehicles[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_write_bytes(file, &nklvl.vehicles[i].direction[0], sizeof(nikola::Vec3));
-    nikola::file_write_bytes(file, &nklvl.vehicles[i].acceleration, sizeof(float));
-    nikola::file_write_bytes(file, &nklvl.vehicles[i].vehicle_type, sizeof(nikola::u8));
+  NIKOLA_LOG_ERROR("Found invalid level binary version %i.%i", nklvl->major_version, nklvl->minor_version);
+  return false;
+}
+
+void nklvl_file_touch(const NKLevelFile& nklvl) {
+  // @NOTE: Mapped levels are only read from disk the first time a page is 
+  // touched. Walking every page here means those faults happen on whichever 
+  // thread calls this instead of in the middle of creating the entities.
+
+  const nikola::sizei page_size = 4096;
+
+  const void* sections_data[NKLVL_SECTIONS_MAX] = {
+    nklvl.points.positions,
+    nklvl.points.scales,
+    nklvl.points.types,
+
+    nklvl.vehicles.positions,
+    nklvl.vehicles.directions,
+    nklvl.vehicles.accelerations,
+    nklvl.vehicles.types,
+
+    nklvl.tiles.positions,
+    nklvl.tiles.types,
+  };
+
+  NKLevelSection sections[NKLVL_SECTIONS_MAX];
+  layout_sections(sections, nklvl.points.count, nklvl.vehicles.count, nklvl.tiles.count);
+
+  volatile nikola::u8 sink = 0;
+  for(nikola::sizei i = 0; i < NKLVL_SECTIONS_MAX; i++) {
+    const nikola::u8* data  = (const nikola::u8*)sections_data[i];
+    nikola::sizei data_size = sections[i].count * sections[i].stride;
+
+    for(nikola::sizei offset = 0; offset < data_size; offset += page_size) {
+      sink = sink + data[offset];
+    }
+  }
+}
+
+void nklvl_file_unload(NKLevelFile* nklvl) {
+  file_mapping_close(&nklvl->mapping);
+  reset_sections(nklvl);
+
+  // Everything the level allocated goes away in one go
+  level_arena_reset(&nklvl->arena);
+}
+
+void nklvl_file_resize(NKLevelFile* nklvl,
+                       const nikola::sizei points_count,
+                       const nikola::sizei vehicles_count,
+                       const nikola::sizei tiles_count) {
+  NKLevelSection sections[NKLVL_SECTIONS_MAX];
+  nikola::sizei image_size = layout_sections(sections, points_count, vehicles_count, tiles_count);
+
+  // @NOTE: The old sections stay alive in the arena until the level 
+  // is unloaded, which is what makes it safe to copy from them here.
+
+  nikola::u8* image = (nikola::u8*)level_arena_push(&nklvl->arena, image_size);
+  write_header(image, *nklvl, sections, image_size);
+
+  // Keep whatever was there before
+
+  NKLevelFile resized;
+  bind_sections(&resized, image, sections);
+
+  nikola::sizei points   = min_count(points_count, nklvl->points.count);
+  nikola::sizei vehicles = min_count(vehicles_count, nklvl->vehicles.count);
+  nikola::sizei tiles    = min_count(tiles_count, nklvl->tiles.count);
+
+  if(points > 0) {
+    memcpy(resized.points.positions, nklvl->points.positions, sizeof(nikola::Vec3) * points);
+    memcpy(resized.points.scales, nklvl->points.scales, sizeof(nikola::Vec3) * points);
+    memcpy(resized.points.types, nklvl->points.types, sizeof(nikola::u16) * points);
+  }
+
+  if(vehicles > 0) {
+    memcpy(resized.vehicles.positions, nklvl->vehicles.positions, sizeof(nikola::Vec3) * vehicles);
+    memcpy(resized.vehicles.directions, nklvl->vehicles.directions, sizeof(nikola::Vec3) * vehicles);
+    memcpy(resized.vehicles.accelerations, nklvl->vehicles.accelerations, sizeof(float) * vehicles);
+    memcpy(resized.vehicles.types, nklvl->vehicles.types, sizeof(nikola::u8) * vehicles);
+  }
+
+  if(tiles > 0) {
+    memcpy(resized.tiles.positions, nklvl->tiles.positions, sizeof(nikola::Vec3) * tiles);
+    memcpy(resized.tiles.types, nklvl->tiles.types, sizeof(nikola::u8) * tiles);
   }
 
-  // Write the tiles 
+  // The level is owned by us from now on. This also
+  // releases the file so it can be saved over.
 
-  nikola::file_write_bytes(file, &nklvl.tiles_count, sizeof(nklvl.tiles_count));
+  file_mapping_close(&nklvl->mapping);
+  bind_sections(nklvl, image, sections);
+}
+
+const nikola::sizei nklvl_file_get_image_size(const NKLevelFile& nklvl) {
+  NKLevelSection sections[NKLVL_SECTIONS_MAX];
+  return layout_sections(sections, nklvl.points.count, nklvl.vehicles.count, nklvl.tiles.count);
+}
+
+void nklvl_file_write(nikola::File& file, const NKLevelFile& nklvl) {
+  // Write the header and the section table
+
+  NKLevelSection sections[NKLVL_SECTIONS_MAX];
+  nikola::sizei image_size = layout_sections(sections, nklvl.points.count, nklvl.vehicles.count, nklvl.tiles.count);
+
+  nikola::u8 header[NKLVL_DATA_OFFSET];
+  write_header(header, nklvl, sections, image_size);
+  nikola::file_write_bytes(file, header, NKLVL_DATA_OFFSET);
+
+  // Write the sections
+
+  const void* sections_data[NKLVL_SECTIONS_MAX] = {
+    nklvl.points.positions,
+    nklvl.points.scales,
+    nklvl.points.types,
+
+    nklvl.vehicles.positions,
+    nklvl.vehicles.directions,
+    nklvl.vehicles.accelerations,
+    nklvl.vehicles.types,
+
+    nklvl.tiles.positions,
+    nklvl.tiles.types,
+  };
+
+  const nikola::u8 padding[NKLVL_SECTION_ALIGNMENT] = {0};
+  nikola::sizei written = NKLVL_DATA_OFFSET;
+
+  for(nikola::sizei i = 0; i < NKLVL_SECTIONS_MAX; i++) {
+    nikola::sizei data_size = sections[i].count * sections[i].stride;
+    if(data_size == 0) {
+      continue;
+    }
 
-  for(nikola::sizei i = 0; i < nklvl.tiles_count; i++) {
-    nikola::file_write_bytes(file, &nklvl.tiles[i].position[0], sizeof(nikola::Vec3));
-    nikola::file_write_bytes(file, &nklvl.tiles[i].tile_type, sizeof(nikola::u8));
+    nikola::file_write_bytes(file, padding, sections[i].offset - written);
+    nikola::file_write_bytes(file, sections_data[i], data_size);
+
+    written = sections[i].offset + data_size;
+  }
+
+  nikola::file_write_bytes(file, padding, image_size - written);
+}
+
+void nklvl_file_save(const NKLevelFile& nklvl) {
+  // Open the file first
+  nikola::File file;
+  if(!nikola::file_open(&file, nklvl.path, (int)(nikola::FILE_OPEN_WRITE | nikola::FILE_OPEN_BINARY))) {
+    NIKOLA_LOG_ERROR("Failed to save the level file at \'%s\'", nklvl.path.c_str());
+    return;
   }
 
+  nklvl_file_write(file, nklvl);
+
   // Always remember to close the file
   nikola::file_close(file);
   NIKOLA_LOG_TRACE("Saved level file at \'%s\'", nklvl.path.c_str());
+
+  // The archived version of this level (if any) is stale now
+  nkpak_file_invalidate(nikola::filepath_filename(nklvl.path));
 }
 
 /// NKLevelFile functions
@@ -0,0 +1,159 @@
+#include "level.h"
+
+#include <nikola/nikola.h>
+
+#include <cstring>
+#include <cstdio>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::u8 NKPAK_VERSION_MAJOR = 0;
+const nikola::u8 NKPAK_VERSION_MINOR = 1;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKPak
+struct NKPak {
+  NKFileMapping mapping;
+  nikola::DynamicArray<NKPakEntry> entries;
+};
+
+static NKPak s_pak;
+
+static_assert(sizeof(NKPakHeader) == 16, "NKPakHeader must stay 16 bytes on disk");
+static_assert(sizeof(NKPakEntry) == 32, "NKPakEntry must stay 32 bytes on disk");
+/// NKPak
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static NKPakEntry* find_entry(const nikola::FilePath& filename) {
+  for(auto& entry : s_pak.entries) {
+    if(strncmp(entry.name, filename.c_str(), sizeof(entry.name)) == 0) {
+      return &entry;
+    }
+  }
+
+  return nullptr;
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// NKPak functions
+
+const bool nkpak_file_open(const nikola::FilePath& path) {
+  nkpak_file_close();
+
+  if(!file_mapping_open(&s_pak.mapping, path)) {
+    NIKOLA_LOG_WARN("Could not find a level archive at \'%s\'", path.c_str());
+    return false;
+  }
+
+  // Read the header
+
+  NKPakHeader header;
+  if(s_pak.mapping.size < sizeof(NKPakHeader)) {
+    nkpak_file_close();
+    return false;
+  }
+  memcpy(&header, s_pak.mapping.data, sizeof(NKPakHeader));
+
+  bool is_valid = (strncmp(header.magic, "NKPK", sizeof(header.magic)) == 0) &&
+                  (header.major_version == NKPAK_VERSION_MAJOR)              &&
+                  (header.minor_version == NKPAK_VERSION_MINOR)              &&
+                  (header.file_size <= s_pak.mapping.size);
+
+  nikola::sizei toc_size = sizeof(NKPakEntry) * header.entries_count;
+  if(!is_valid || header.toc_offset > header.file_size || toc_size > (header.file_size - header.toc_offset)) {
+    NIKOLA_LOG_ERROR("Invalid level archive at \'%s\'", path.c_str());
+
+    nkpak_file_close();
+    return false;
+  }
+
+  // Read the whole table of contents at once
+
+  s_pak.entries.resize(header.entries_count);
+  memcpy(s_pak.entries.data(), s_pak.mapping.data + header.toc_offset, toc_size);
+
+  for(auto& entry : s_pak.entries) {
+    entry.name[sizeof(entry.name) - 1] = 0;
+
+    // An entry pointing outside the archive is as good as not being there
+    if(entry.offset > header.file_size || entry.size > (header.file_size - entry.offset)) {
+      NIKOLA_LOG_ERROR("Invalid level archive entry \'%s\'", entry.name);
+      entry.size = 0;
+    }
+  }
+
+  NIKOLA_LOG_INFO("Opened level archive at \'%s\' with %zu levels", path.c_str(), s_pak.entries.size());
+  return true;
+}
+
+void nkpak_file_close() {
+  file_mapping_close(&s_pak.mapping);
+  s_pak.entries.clear();
+}
+
+const nikola::DynamicArray<NKPakEntry>& nkpak_file_get_entries() {
+  return s_pak.entries;
+}
+
+const bool nkpak_file_find(const nikola::FilePath& filename, nikola::u8** data, nikola::sizei* size) {
+  NKPakEntry* entry = find_entry(filename);
+  if(!entry || entry->size == 0) {
+    return false;
+  }
+
+  *data = s_pak.mapping.data + entry->offset;
+  *size = entry->size;
+
+  return true;
+}
+
+void nkpak_file_invalidate(const nikola::FilePath& filename) {
+  NKPakEntry* entry = find_entry(filename);
+  if(!entry) {
+    return;
+  }
+
+  // Fall back to the loose file from now on
+  entry->size = 0;
+}
+
+const bool nkpak_parse_level_name(const nikola::FilePath& filename, nikola::u8* group_index, nikola::u8* level_index) {
+  /*
+   * @NOTE:
+   *
+   * Since all levels have the `C#L#` convention, where `C` stands for "Chapter" and `L` stands
+   * for "Level", we can extract both numbers from the filename to determine which group
+   * the level belongs to and where it sits in that group.
+   *
+   * This is only used when building the archive, or when the game runs without one. 
+   * Otherwise, the indices come straight from the table of contents.
+   *
+  */
+
+  int group = 0, level = 0;
+  if(sscanf(filename.c_str(), "C%dL%d", &group, &level) != 2) {
+    return false;
+  }
+
+  if(group < 0 || group >= (int)LEVEL_GROUPS_MAX || level < 0 || level > 255) {
+    return false;
+  }
+
+  *group_index = (nikola::u8)group;
+  *level_index = (nikola::u8)level;
+
+  return true;
+}
+
+/// NKPak functions
+/// ----------------------------------------------------------------------
@@ -12,6 +12,8 @@
 struct SoundManager {
   nikola::AudioSourceID entries[SOUNDS_MAX];
   nikola::sizei current_music = SOUND_AMBIANCE;
+
+  GameEventScope event_scope;
 };
 
 static SoundManager s_manager;
@@ -97,14 +99,16 @@ void sound_manager_init() {
   nikola::audio_listener_init(listen_desc); 
 
   // Listen to events
-  game_event_listen(GAME_EVENT_SOUND_PLAYED, on_sound_play);
-  game_event_listen(GAME_EVENT_MUSIC_PLAYED, on_sound_play);
-  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_change);
+  game_event_listen(GAME_EVENT_SOUND_PLAYED, on_sound_play, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_MUSIC_PLAYED, on_sound_play, nullptr, &s_manager.event_scope);
+  game_event_listen(GAME_EVENT_STATE_CHANGED, on_state_change, nullptr, &s_manager.event_scope);
 
   NIKOLA_LOG_DEBUG("Initialized sound manager");
 }
 
 void sound_manager_shutdown() {
+  game_event_scope_clear(&s_manager.event_scope);
+
   // Sources destroy
   for(nikola::sizei i = 0; i < SOUNDS_MAX; i++) {
     nikola::audio_source_destroy(s_manager.entries[i]);
@@ -0,0 +1,149 @@
+#include "levels/level.h"
+
+#include <nikola/nikola.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+const nikola::u8 NKPAK_VERSION_MAJOR = 0;
+const nikola::u8 NKPAK_VERSION_MINOR = 1;
+
+// Levels are aligned inside the archive so their sections stay aligned when mapped
+const nikola::sizei NKPAK_ENTRY_ALIGNMENT = 16;
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// PakLevel
+struct PakLevel {
+  nikola::FilePath path;
+  NKPakEntry entry;
+};
+/// PakLevel
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static nikola::sizei align_offset(const nikola::sizei offset) {
+  return (offset + (NKPAK_ENTRY_ALIGNMENT - 1)) & ~(NKPAK_ENTRY_ALIGNMENT - 1);
+}
+
+static void level_directory_iterate_func(const nikola::FilePath& base_dir, const nikola::FilePath& current_dir, void* user_data) {
+  nikola::DynamicArray<PakLevel>* levels = (nikola::DynamicArray<PakLevel>*)user_data;
+  nikola::FilePath filename              = nikola::filepath_filename(current_dir);
+
+  PakLevel level = {
+    .path  = current_dir,
+    .entry = {},
+  };
+
+  if(filename.size() >= sizeof(level.entry.name) ||
+     !nkpak_parse_level_name(filename, &level.entry.group_index, &level.entry.level_index)) {
+    NIKOLA_LOG_WARN("Skipping \'%s\' since it does not follow the `C#L#.nklvl` convention", current_dir.c_str());
+    return;
+  }
+
+  memcpy(level.entry.name, filename.c_str(), filename.size());
+  levels->push_back(level);
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Main
+
+int main(int argc, char** argv) {
+  if(argc < 3) {
+    printf("Usage: nkpak <levels directory> <output archive>\n");
+    return -1;
+  }
+
+  nikola::FilePath levels_dir = argv[1];
+  nikola::FilePath out_path   = argv[2];
+
+  // Gather all of the levels
+
+  nikola::DynamicArray<PakLevel> levels;
+  nikola::filesystem_directory_iterate(levels_dir, level_directory_iterate_func, &levels);
+
+  std::sort(levels.begin(), levels.end(), [](const PakLevel& a, const PakLevel& b) {
+    if(a.entry.group_index != b.entry.group_index) {
+      return a.entry.group_index < b.entry.group_index;
+    }
+
+    return a.entry.level_index < b.entry.level_index;
+  });
+
+  // Figure out where each level will end up. Every level gets
+  // converted to the latest version on the way in.
+
+  NKLevelFile nklvl;
+  nikola::sizei offset = align_offset(sizeof(NKPakHeader) + (sizeof(NKPakEntry) * levels.size()));
+
+  for(auto& level : levels) {
+    if(!nklvl_file_load(&nklvl, level.path)) {
+      return -1;
+    }
+
+    level.entry.offset = (nikola::u32)offset;
+    level.entry.size   = (nikola::u32)nklvl_file_get_image_size(nklvl);
+
+    offset = align_offset(offset + level.entry.size);
+  }
+
+  // Write the header and the table of contents
+
+  nikola::File file;
+  if(!nikola::file_open(&file, out_path, (int)(nikola::FILE_OPEN_WRITE | nikola::FILE_OPEN_BINARY))) {
+    NIKOLA_LOG_ERROR("Failed to open level archive at \'%s\'", out_path.c_str());
+    return -1;
+  }
+
+  NKPakHeader header = {
+    .magic         = {'N', 'K', 'P', 'K'},
+    .major_version = NKPAK_VERSION_MAJOR,
+    .minor_version = NKPAK_VERSION_MINOR,
+    .entries_count = (nikola::u16)levels.size(),
+    .toc_offset    = sizeof(NKPakHeader),
+    .file_size     = (nikola::u32)offset,
+  };
+  nikola::file_write_bytes(file, &header, sizeof(NKPakHeader));
+
+  for(auto& level : levels) {
+    nikola::file_write_bytes(file, &level.entry, sizeof(NKPakEntry));
+  }
+
+  // Write the levels themselves
+
+  const nikola::u8 padding[NKPAK_ENTRY_ALIGNMENT] = {0};
+  nikola::sizei written = sizeof(NKPakHeader) + (sizeof(NKPakEntry) * levels.size());
+
+  for(auto& level : levels) {
+    nklvl_file_load(&nklvl, level.path);
+
+    nikola::file_write_bytes(file, padding, level.entry.offset - written);
+    nklvl_file_write(file, nklvl);
+
+    written = level.entry.offset + level.entry.size;
+    NIKOLA_LOG_TRACE("Packed \'%s\' into group %i", level.entry.name, level.entry.group_index);
+  }
+
+  nikola::file_write_bytes(file, padding, offset - written);
+  nikola::file_close(file);
+
+  nklvl_file_unload(&nklvl);
+  level_arena_destroy(&nklvl.arena);
+
+  NIKOLA_LOG_INFO("Packed %zu levels into \'%s\'", levels.size(), out_path.c_str());
+  return 0;
+}
+
+/// Main
+/// ----------------------------------------------------------------------
@@ -0,0 +1,534 @@
+#include "levels/level.h"
+#include "entities/entity.h"
+
+#include <nikola/nikola.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+/// ----------------------------------------------------------------------
+/// Consts
+
+// Every decision lasts this many simulation steps
+const nikola::sizei SOLVER_SUBSTEPS = 12;
+const float SOLVER_STEP             = LEVEL_FIXED_STEP * SOLVER_SUBSTEPS;
+
+// Exactly one decision worth of movement, so every move lands on another cell
+const float SOLVER_CELL_SIZE = PLAYER_SPEED * SOLVER_STEP;
+
+// One minute of gameplay, which is plenty for any level
+const float SOLVER_TIME_MAX = 60.0f;
+
+/// @NOTE: The coin's collider is rotated on its side and spins around the Y axis.
+/// This is roughly the box it sweeps through.
+const nikola::Vec3 SOLVER_COIN_HALF_EXTENTS = nikola::Vec3(0.7f, 2.0f, 0.7f);
+
+const nikola::sizei SOLVER_WORD_BITS = 64;
+
+// Staying in place and all 8 directions
+const int SOLVER_MOVES_MAX = 9;
+const int SOLVER_MOVES[SOLVER_MOVES_MAX][2] = {
+  {0, 0},
+  {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+  {1, 1}, {1, -1}, {-1, 1}, {-1, -1},
+};
+
+/// Consts
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// SolverVehicle
+struct SolverVehicle {
+  nikola::Vec3 start_pos;
+  nikola::Vec3 direction;
+
+  float acceleration;
+  float lane_length;
+
+  AABB box; // Relative to the vehicle's position
+};
+/// SolverVehicle
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// SolverGrid
+struct SolverGrid {
+  nikola::Vec3 origin; // The world position of cell (0, 0)
+  int width, depth;
+
+  nikola::DynamicArray<nikola::u64> walkable; // Ground with nothing in the way
+  nikola::DynamicArray<nikola::u64> deadly;   // Death and vehicle points
+  nikola::DynamicArray<nikola::u64> goal;     // End points
+  nikola::DynamicArray<nikola::u64> coin;
+  nikola::DynamicArray<nikola::u64> traffic;  // Vehicles at any point during the current decision
+};
+/// SolverGrid
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// LevelSolution
+struct LevelSolution {
+  nikola::FilePath path;
+
+  bool is_loaded   = false;
+  bool is_solvable = false;
+  bool has_coin    = false;
+  bool got_coin    = false;
+
+  float solution_time = 0.0f; // Shortest time to any end point
+  float coin_time     = 0.0f; // Shortest time to an end point with the coin
+
+  nikola::sizei states_count = 0;
+  nikola::f64 wall_time      = 0.0;
+};
+/// LevelSolution
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Private functions
+
+static nikola::f64 get_time() {
+  // Only the difference matters, and the engine's clock needs the whole engine
+  return std::chrono::duration<nikola::f64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void level_directory_iterate_func(const nikola::FilePath& base_dir, const nikola::FilePath& current_dir, void* user_data) {
+  nikola::DynamicArray<nikola::FilePath>* paths = (nikola::DynamicArray<nikola::FilePath>*)user_data;
+
+  nikola::u8 group_index, level_index;
+  if(nkpak_parse_level_name(nikola::filepath_filename(current_dir), &group_index, &level_index)) {
+    paths->push_back(current_dir);
+  }
+}
+
+static bool bit_test(const nikola::DynamicArray<nikola::u64>& bits, const nikola::sizei index) {
+  return (bits[index / SOLVER_WORD_BITS] >> (index % SOLVER_WORD_BITS)) & 1;
+}
+
+static void bit_set(nikola::DynamicArray<nikola::u64>& bits, const nikola::sizei index) {
+  bits[index / SOLVER_WORD_BITS] |= ((nikola::u64)1 << (index % SOLVER_WORD_BITS));
+}
+
+static void bit_clear_all(nikola::DynamicArray<nikola::u64>& bits, const nikola::sizei count) {
+  bits.assign((count + SOLVER_WORD_BITS - 1) / SOLVER_WORD_BITS, 0);
+}
+
+static void rasterize_box(const SolverGrid& grid, const AABB& box, nikola::DynamicArray<nikola::u64>& bits) {
+  // Every cell the player would overlap `box` from
+
+  nikola::Vec3 half_player = PLAYER_COLLIDER_EXTENTS / 2.0f;
+  if((box.min.y >= grid.origin.y + half_player.y) || (box.max.y <= grid.origin.y - half_player.y)) {
+    return;
+  }
+
+  int min_x = (int)floorf((box.min.x - half_player.x - grid.origin.x) / SOLVER_CELL_SIZE) + 1;
+  int max_x = (int)ceilf((box.max.x + half_player.x - grid.origin.x) / SOLVER_CELL_SIZE) - 1;
+  int min_z = (int)floorf((box.min.z - half_player.z - grid.origin.z) / SOLVER_CELL_SIZE) + 1;
+  int max_z = (int)ceilf((box.max.z + half_player.z - grid.origin.z) / SOLVER_CELL_SIZE) - 1;
+
+  min_x = std::max(min_x, 0);
+  min_z = std::max(min_z, 0);
+  max_x = std::min(max_x, grid.width - 1);
+  max_z = std::min(max_z, grid.depth - 1);
+
+  for(int z = min_z; z <= max_z; z++) {
+    for(int x = min_x; x <= max_x; x++) {
+      bit_set(bits, (nikola::sizei)(z * grid.width + x));
+    }
+  }
+}
+
+static void build_grid(const NKLevelFile& nklvl, SolverGrid* grid) {
+  const nikola::Vec3& start = nklvl.start_position;
+
+  // The player can only go as far as the ground goes
+
+  float min_z = start.z;
+  float max_z = start.z;
+  for(nikola::sizei i = 0; i < nklvl.tiles.count; i++) {
+    float half_size = tile_get_scale((TileType)nklvl.tiles.types[i]).z / 2.0f;
+
+    min_z = std::min(min_z, nklvl.tiles.positions[i].z - half_size);
+    max_z = std::max(max_z, nklvl.tiles.positions[i].z + half_size);
+  }
+
+  // The start position is always right on a cell
+
+  int cells_behind = (int)floorf((start.x - PLAYER_MIN_X) / SOLVER_CELL_SIZE);
+  int cells_left   = (int)floorf((start.z - min_z) / SOLVER_CELL_SIZE);
+
+  grid->origin = nikola::Vec3(start.x - (cells_behind * SOLVER_CELL_SIZE), start.y, start.z - (cells_left * SOLVER_CELL_SIZE));
+  grid->width  = cells_behind + (int)floorf((PLAYER_MAX_X - start.x) / SOLVER_CELL_SIZE) + 1;
+  grid->depth  = cells_left + (int)floorf((max_z - start.z) / SOLVER_CELL_SIZE) + 1;
+
+  nikola::sizei cells_count = (nikola::sizei)(grid->width * grid->depth);
+  bit_clear_all(grid->walkable, cells_count);
+  bit_clear_all(grid->deadly, cells_count);
+  bit_clear_all(grid->goal, cells_count);
+  bit_clear_all(grid->coin, cells_count);
+  bit_clear_all(grid->traffic, cells_count);
+
+  // Ground first...
+
+  nikola::DynamicArray<nikola::u64> obstacles;
+  bit_clear_all(obstacles, cells_count);
+
+  for(nikola::sizei i = 0; i < nklvl.tiles.count; i++) {
+    TileType type = (TileType)nklvl.tiles.types[i];
+
+    nikola::Vec3 position = tile_get_position(type, nklvl.tiles.positions[i]);
+    nikola::Vec3 extents  = tile_get_scale(type) / 2.0f;
+
+    if(!tile_is_ground(type)) {
+      // Obstacles block the player no matter how high they are
+
+      AABB box = AABB{position - extents, position + extents};
+      box.min.y = start.y - PLAYER_COLLIDER_EXTENTS.y;
+      box.max.y = start.y + PLAYER_COLLIDER_EXTENTS.y;
+
+      rasterize_box(*grid, box, obstacles);
+      continue;
+    }
+
+    // Standing on the ground only needs the center to be above it
+
+    int min_x = (int)ceilf((position.x - extents.x - grid->origin.x) / SOLVER_CELL_SIZE);
+    int max_x = (int)floorf((position.x + extents.x - grid->origin.x) / SOLVER_CELL_SIZE);
+    int min_z = (int)ceilf((position.z - extents.z - grid->origin.z) / SOLVER_CELL_SIZE);
+    int max_z = (int)floorf((position.z + extents.z - grid->origin.z) / SOLVER_CELL_SIZE);
+
+    for(int z = std::max(min_z, 0); z <= std::min(max_z, grid->depth - 1); z++) {
+      for(int x = std::max(min_x, 0); x <= std::min(max_x, grid->width - 1); x++) {
+        bit_set(grid->walkable, (nikola::sizei)(z * grid->width + x));
+      }
+    }
+  }
+
+  // ...then take away whatever is in the way
+
+  for(nikola::sizei i = 0; i < grid->walkable.size(); i++) {
+    grid->walkable[i] &= ~obstacles[i];
+  }
+
+  // Points
+
+  for(nikola::sizei i = 0; i < nklvl.points.count; i++) {
+    nikola::Vec3 extents = nklvl.points.scales[i] / 2.0f;
+    AABB box             = AABB{nklvl.points.positions[i] - extents, nklvl.points.positions[i] + extents};
+
+    switch((EntityType)nklvl.points.types[i]) {
+      case ENTITY_END_POINT:
+        rasterize_box(*grid, box, grid->goal);
+        break;
+      case ENTITY_DEATH_POINT:
+      case ENTITY_VEHICLE_POINT:
+        rasterize_box(*grid, box, grid->deadly);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Coin
+
+  if(nklvl.has_coin) {
+    AABB box = AABB{nklvl.coin_position - SOLVER_COIN_HALF_EXTENTS, nklvl.coin_position + SOLVER_COIN_HALF_EXTENTS};
+    rasterize_box(*grid, box, grid->coin);
+  }
+}
+
+static void build_vehicles(const NKLevelFile& nklvl, nikola::DynamicArray<SolverVehicle>& vehicles) {
+  nikola::DynamicArray<AABB> stops;
+  for(nikola::sizei i = 0; i < nklvl.points.count; i++) {
+    if((EntityType)nklvl.points.types[i] != ENTITY_VEHICLE_POINT) {
+      continue;
+    }
+
+    nikola::Vec3 extents = nklvl.points.scales[i] / 2.0f;
+    stops.push_back(AABB{nklvl.points.positions[i] - extents, nklvl.points.positions[i] + extents});
+  }
+
+  vehicles.resize(nklvl.vehicles.count);
+  for(nikola::sizei i = 0; i < vehicles.size(); i++) {
+    VehicleType type = (VehicleType)nklvl.vehicles.types[i];
+
+    vehicles[i] = SolverVehicle {
+      .start_pos    = nklvl.vehicles.positions[i],
+      .direction    = nklvl.vehicles.directions[i],
+      .acceleration = nklvl.vehicles.accelerations[i],
+      .lane_length  = vehicle_get_lane_length(type, nklvl.vehicles.positions[i], nklvl.vehicles.directions[i], stops),
+      .box          = vehicle_get_collider_box(type),
+    };
+  }
+}
+
+static void build_traffic(SolverGrid* grid, const nikola::DynamicArray<SolverVehicle>& vehicles, const float start_time) {
+  /// @NOTE: Any cell a vehicle touches at any step of the decision counts.
+  /// That is stricter than the game, so whatever the solver finds can be played back.
+
+  std::fill(grid->traffic.begin(), grid->traffic.end(), 0);
+
+  for(nikola::sizei step = 0; step <= SOLVER_SUBSTEPS; step++) {
+    float time = start_time + (step * LEVEL_FIXED_STEP);
+
+    for(auto& vehicle : vehicles) {
+      float distance        = vehicle_get_lane_distance(vehicle.acceleration, vehicle.lane_length, time);
+      nikola::Vec3 position = vehicle.start_pos + vehicle.direction * distance;
+
+      rasterize_box(*grid, aabb_translate(vehicle.box, position), grid->traffic);
+    }
+  }
+}
+
+static const bool is_cell_safe(const SolverGrid& grid, const nikola::sizei cell) {
+  return bit_test(grid.walkable, cell) && !bit_test(grid.deadly, cell) && !bit_test(grid.traffic, cell);
+}
+
+static void solve_level(LevelSolution* solution) {
+  nikola::f64 start_time = get_time();
+
+  NKLevelFile nklvl;
+  solution->is_loaded = nklvl_file_load(&nklvl, solution->path);
+  if(!solution->is_loaded) {
+    return;
+  }
+
+  SolverGrid grid;
+  build_grid(nklvl, &grid);
+
+  nikola::DynamicArray<SolverVehicle> vehicles;
+  build_vehicles(nklvl, vehicles);
+
+  nikola::sizei start_cell = (nikola::sizei)(
+    (int)roundf((nklvl.start_position.z - grid.origin.z) / SOLVER_CELL_SIZE) * grid.width +
+    (int)roundf((nklvl.start_position.x - grid.origin.x) / SOLVER_CELL_SIZE)
+  );
+  solution->has_coin = nklvl.has_coin;
+
+  nklvl_file_unload(&nklvl);
+  level_arena_destroy(&nklvl.arena);
+
+  /// @NOTE: The search goes one decision at a time. Every state that can be
+  /// reached at one point in time makes up the frontier of the next one,
+  /// so the first time an end point shows up is also the shortest way there.
+  ///
+  /// A state is a cell plus whether the coin was picked up on the way.
+
+  nikola::sizei cells_count  = (nikola::sizei)(grid.width * grid.depth);
+  nikola::sizei states_count = cells_count * 2;
+
+  nikola::DynamicArray<nikola::u32> frontier, next_frontier;
+  nikola::DynamicArray<nikola::u64> visited;
+
+  frontier.push_back((nikola::u32)(start_cell * 2));
+
+  nikola::sizei layers_max = (nikola::sizei)(SOLVER_TIME_MAX / SOLVER_STEP);
+  for(nikola::sizei layer = 0; layer < layers_max && !frontier.empty(); layer++) {
+    build_traffic(&grid, vehicles, layer * SOLVER_STEP);
+
+    bit_clear_all(visited, states_count);
+    next_frontier.clear();
+
+    for(auto& state : frontier) {
+      nikola::sizei cell = state / 2;
+      bool has_coin      = state & 1;
+
+      int x = (int)(cell % grid.width);
+      int z = (int)(cell / grid.width);
+
+      // Run over while standing still?
+      if(!is_cell_safe(grid, cell)) {
+        continue;
+      }
+
+      for(int i = 0; i < SOLVER_MOVES_MAX; i++) {
+        int next_x = x + SOLVER_MOVES[i][0];
+        int next_z = z + SOLVER_MOVES[i][1];
+        if(next_x < 0 || next_x >= grid.width || next_z < 0 || next_z >= grid.depth) {
+          continue;
+        }
+
+        nikola::sizei next_cell = (nikola::sizei)(next_z * grid.width + next_x);
+        if(!is_cell_safe(grid, next_cell)) {
+          continue;
+        }
+
+        bool next_has_coin = has_coin || bit_test(grid.coin, next_cell);
+        float time         = (layer + 1) * SOLVER_STEP;
+
+        // Made it!
+
+        if(bit_test(grid.goal, next_cell)) {
+          if(!solution->is_solvable) {
+            solution->is_solvable   = true;
+            solution->solution_time = time;
+          }
+
+          if(next_has_coin && !solution->got_coin) {
+            solution->got_coin  = true;
+            solution->coin_time = time;
+          }
+
+          // The level is over once an end point is touched
+          continue;
+        }
+
+        nikola::u32 next_state = (nikola::u32)(next_cell * 2 + next_has_coin);
+        if(bit_test(visited, next_state)) {
+          continue;
+        }
+
+        bit_set(visited, next_state);
+        next_frontier.push_back(next_state);
+      }
+    }
+
+    solution->states_count += next_frontier.size();
+    frontier.swap(next_frontier);
+
+    // Nothing else to look for
+    if(solution->is_solvable && (solution->got_coin || !solution->has_coin)) {
+      break;
+    }
+  }
+
+  solution->wall_time = get_time() - start_time;
+}
+
+static void write_report(const nikola::FilePath& path, const nikola::DynamicArray<LevelSolution>& solutions) {
+  FILE* file = fopen(path.c_str(), "w");
+  if(!file) {
+    NIKOLA_LOG_ERROR("Failed to open report file at \'%s\'", path.c_str());
+    return;
+  }
+
+  fprintf(file, "level,solvable,solution_time,has_coin,coin_time,states,wall_time_ms\n");
+  for(auto& solution : solutions) {
+    fprintf(file, "%s,%i,%.2f,%i,%.2f,%zu,%.3f\n",
+            nikola::filepath_filename(solution.path).c_str(),
+            solution.is_solvable,
+            solution.solution_time,
+            solution.has_coin,
+            solution.got_coin ? solution.coin_time : -1.0f,
+            solution.states_count,
+            solution.wall_time * 1000.0);
+  }
+
+  fclose(file);
+}
+
+/// Private functions
+/// ----------------------------------------------------------------------
+
+/// ----------------------------------------------------------------------
+/// Main
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    printf("Usage: nksolve <levels directory> [report.csv]\n");
+    return -1;
+  }
+
+  // Gather all of the levels
+
+  nikola::DynamicArray<nikola::FilePath> paths;
+  nikola::filesystem_directory_iterate(argv[1], level_directory_iterate_func, &paths);
+  std::sort(paths.begin(), paths.end());
+
+  nikola::DynamicArray<LevelSolution> solutions(paths.size());
+  for(nikola::sizei i = 0; i < paths.size(); i++) {
+    solutions[i].path = paths[i];
+  }
+
+  // Every level is independent of the others, so each worker
+  // just keeps grabbing the next level until there are none left.
+
+  nikola::f64 start_time = get_time();
+
+  nikola::sizei workers_count = std::max(std::thread::hardware_concurrency(), 1u);
+  workers_count               = std::min(workers_count, std::max(solutions.size(), (nikola::sizei)1));
+
+  std::atomic<nikola::sizei> next_level = 0;
+  nikola::DynamicArray<std::thread> workers;
+
+  for(nikola::sizei i = 0; i < workers_count; i++) {
+    workers.emplace_back([&solutions, &next_level]() {
+      for(nikola::sizei index = next_level++; index < solutions.size(); index = next_level++) {
+        solve_level(&solutions[index]);
+      }
+    });
+  }
+
+  for(auto& worker : workers) {
+    worker.join();
+  }
+
+  nikola::f64 total_time = get_time() - start_time;
+
+  // Report
+
+  nikola::sizei solvable_count = 0;
+  for(auto& solution : solutions) {
+    nikola::FilePath name = nikola::filepath_filename(solution.path);
+
+    if(!solution.is_loaded) {
+      NIKOLA_LOG_ERROR("[SOLVER] %s: failed to load", name.c_str());
+      continue;
+    }
+
+    if(!solution.is_solvable) {
+      NIKOLA_LOG_WARN("[SOLVER] %s: UNSOLVABLE within %.0fs (%zu states, %.3fms)",
+                      name.c_str(),
+                      SOLVER_TIME_MAX,
+                      solution.states_count,
+                      solution.wall_time * 1000.0);
+      continue;
+    }
+
+    solvable_count++;
+
+    if(solution.has_coin && !solution.got_coin) {
+      NIKOLA_LOG_WARN("[SOLVER] %s: solvable in %.2fs, but the coin is out of reach (%zu states, %.3fms)",
+                      name.c_str(),
+                      solution.solution_time,
+                      solution.states_count,
+                      solution.wall_time * 1000.0);
+      continue;
+    }
+
+    if(solution.has_coin) {
+      NIKOLA_LOG_INFO("[SOLVER] %s: solvable in %.2fs, %.2fs with the coin (%zu states, %.3fms)",
+                      name.c_str(),
+                      solution.solution_time,
+                      solution.coin_time,
+                      solution.states_count,
+                      solution.wall_time * 1000.0);
+      continue;
+    }
+
+    NIKOLA_LOG_INFO("[SOLVER] %s: solvable in %.2fs (%zu states, %.3fms)",
+                    name.c_str(),
+                    solution.solution_time,
+                    solution.states_count,
+                    solution.wall_time * 1000.0);
+  }
+
+  NIKOLA_LOG_INFO("[SOLVER] %zu/%zu levels solvable in %.3fms on %zu threads",
+                  solvable_count,
+                  solutions.size(),
+                  total_time * 1000.0,
+                  workers_count);
+
+  if(argc > 2) {
+    write_report(argv[2], solutions);
+  }
+
+  return solvable_count == solutions.size() ? 0 : 1;
+}
+
+/// Main
+/// ----------------------------------------------------------------------